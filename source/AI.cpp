@@ -1,26 +1,29 @@
 #include "AI.h"
 #include "Timer.h"
-#include "Heuristics.h"
+#include "Log.h"
 
 #include <algorithm>
-#include <limits>
-#include <functional>
-#include <cstring>
+#include <cmath>
 #include <cassert>
 
-using std::cout;
-using std::endl;
-using namespace std::placeholders;
+// Largest number of opponent replies that are pondered at the same time
+static const unsigned int MAX_PONDER_CANDIDATES = 4;
 
-static unsigned int GetHistoryTableIndex(const ivec2& pos)
+// Replies which the opponent is less likely to play than this are not pondered
+static const double MIN_PONDER_PROBABILITY = 0.05;
+
+// Score difference in centipawns at which a reply is e times less likely to be played than the best reply
+static const double PONDER_TEMPERATURE = 100.0;
+
+// Depth of the search predicting the opponent replies
+static const int PONDER_PREDICTION_DEPTH = 3;
+
+AI::AI(Connection* conn, unsigned int depth) : BaseAI(conn), m_totalTime(0), m_count(1), m_depth(depth),
+	m_bStopMinimax(false), m_ponderHits(0), m_ponderMisses(0), m_ponderTimeSaved(0), m_history(),
+	m_randEngine(std::chrono::system_clock::now().time_since_epoch().count())
 {
-	return (8*(pos.x - 1) + (pos.y - 1));
 }
 
-AI::AI(Connection* conn, unsigned int depth) : BaseAI(conn), m_totalTime(0), m_count(1),
-	m_depth(depth), m_bInCheckmate(false), m_bStopMinimax(false), m_bFoundOpponentMove(false),
-	m_randEngine(std::chrono::system_clock::now().time_since_epoch().count()) {}
-
 const char* AI::username()
 {
 	return "Cole Xemi";
@@ -42,38 +45,81 @@ bool AI::run()
 {
 	bool bRestartMinimax = true;
 
-	Timer waitTimer;
-	waitTimer.Start();
+	// The clock is already running while waiting on the ponder thread
+	m_timeManager.Start(players[playerID()].time(), turnNumber() / 2);
 	
-	// Check to see whether or not the last move that was made matched the predicted move from minimax
+	// Check to see whether or not the last move that was made matched one of the moves predicted while pondering
 	if(!moves.empty() && m_ponderingFuture.valid())
 	{
+		// The promotion type is part of the move, an underpromotion does not hit a predicted queen promotion
 		const Move& lastMove = moves[0];
-		
-		m_bestMoveMutex.lock();
-		bool bFoundValidPonderMove = (m_bFoundOpponentMove && (m_opponentBestMove.from == ivec2{lastMove.fromFile(), lastMove.fromRank()}) && 
-									 (m_opponentBestMove.to == ivec2{lastMove.toFile(), lastMove.toRank()}));
-		m_bestMoveMutex.unlock();
-		
-		if(bFoundValidPonderMove)
+		BoardMove opponentMove({lastMove.fromFile(), lastMove.fromRank()}, {lastMove.toFile(), lastMove.toRank()}, 0, lastMove.promoteType());
+
+		PonderCandidate* pHit = nullptr;
+
+		m_ponderMutex.lock();
+		for(auto& pCandidate : m_ponderCandidates)
+		{
+			if((pHit == nullptr) && (pCandidate->opponentMove == opponentMove))
+			{
+				pHit = pCandidate.get();
+			}
+			else
+			{
+				pCandidate->bStop = true;
+			}
+		}
+
+		if(pHit != nullptr)
 		{
-			// The ponder thread can finish executing
-			cout << "Ponder Hit" << endl;
-			bRestartMinimax = false;
+			// The ponder search becomes the search of this turn, it keeps its depth and is stopped by the time manager
+			pHit->bHit = true;
 		}
 		else
 		{
-			// Signal the thread to finish
-			cout << "Ponder miss" << endl;
+			// Signal the pondering thread to finish, this also stops the prediction if it is still running
 			m_bStopMinimax = true;
 		}
+		m_ponderMutex.unlock();
 		
-		WaitForFuture(m_ponderingFuture, true);
-		
-		m_bFoundOpponentMove = false;
+		if(pHit != nullptr)
+		{
+			std::uint64_t timeSaved = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - pHit->searchStart).count();
+			LOG_INFO("Ponder Hit, probability: {}", pHit->probability);
+			++m_ponderHits;
+
+			WaitForFuture(m_ponderingFuture, pHit->bStop);
+
+			// When the ponder search ended before the hit, the search of this turn starts over with the cached results
+			if(pHit->bContinued && pHit->bFoundMove)
+			{
+				LOG_INFO("Ponder time saved: {}", timeSaved / 1000000000.0);
+				m_ponderTimeSaved += timeSaved;
+				m_bestMove = pHit->bestMove;
+				bRestartMinimax = false;
+			}
+
+			m_history = pHit->history;
+		}
+		else
+		{
+			LOG_INFO("Ponder miss");
+			++m_ponderMisses;
+
+			WaitForFuture(m_ponderingFuture, m_bStopMinimax);
+
+			// The most likely reply is the closest to the position that was played
+			if(!m_ponderCandidates.empty())
+			{
+				m_history = m_ponderCandidates.front()->history;
+			}
+		}
+
+		m_ponderCandidates.clear();
 	}
 	
-	cout << "Waiting Time: " << waitTimer.GetTime() << endl;
+	LOG_INFO("Waiting Time: {}", m_timeManager.GetElapsedTime());
+	LOG_DEBUG("Soft limit: {} Hard limit: {}", m_timeManager.GetSoftLimit(), m_timeManager.GetHardLimit());
 
 #ifdef DEBUG_OUTPUT
 	Timer timer;
@@ -85,69 +131,65 @@ bool AI::run()
 #endif
 
 	// Refill the board with updated info from the server
-	m_board.Update(TurnsToStalemate(), moves, pieces);
+	UpdateBoard();
 
 	if(bRestartMinimax)
 	{
-		m_bStopMinimax = false;
-		auto minimaxFuture = std::async(std::launch::async, [this]()
+		std::vector<BoardMove> rootMoves = m_board.GetMoves(playerID());
+		if(rootMoves.size() == 1)
 		{
-			cout << "Normal" << endl;
-			
-			// Find the best move using Minimax
-			MiniMax(playerID(), false, m_bestMove);
-		});
-		
-		WaitForFuture(minimaxFuture);
+			// There is nothing to search when only one move can be made
+			LOG_INFO("Forced move");
+			m_bestMove = rootMoves.front();
+		}
+		else
+		{
+			Search search(m_board, m_transpositionTable, m_timeManager, m_bStopMinimax, m_depth, m_randEngine());
+			search.SetHistory(m_history);
+
+			m_transpositionTable.NewSearch();
+			m_bStopMinimax = false;
+			auto minimaxFuture = std::async(std::launch::async, [this, &search]()
+			{
+				LOG_INFO("Normal");
+
+				// Find the best move using Minimax
+				search.MiniMax(playerID(), false, m_bestMove, true);
+			});
+
+			WaitForFuture(minimaxFuture, m_bStopMinimax);
+			m_history = search.GetHistory();
+		}
 	}
 
-	// Get the piece to move
-	BoardPiece* pPiece = m_board.GetPiece(m_bestMove.from);
+	// Get the piece to move, the board keeps the identifiers of the server pieces
+	const BoardPiece* pPiece = m_board.GetPiece(m_bestMove.from);
 	assert(pPiece != nullptr);
-	pPiece->piece.move(m_bestMove.to.x, m_bestMove.to.y, m_bestMove.promotion);
+
+	for(Piece& piece : pieces)
+	{
+		if(piece.id() == pPiece->id)
+		{
+			piece.move(m_bestMove.to.x, m_bestMove.to.y, m_bestMove.promotion);
+			break;
+		}
+	}
 
 #ifdef DEBUG_OUTPUT
 	m_totalTime += timer.GetTime();
-	cout << "Average Time: " << m_totalTime / m_count << endl;
-	cout << "Server time: " << 900 - players[playerID()].time() << endl;
+	LOG_DEBUG("Average Time: {}", m_totalTime / m_count);
+	LOG_DEBUG("Server time: {}", 900 - players[playerID()].time());
 	m_count++;
 #endif
 
 	// Launch pondering thread
+	BoardMove ourMove = m_bestMove;
+	std::uint64_t opponentTime = TimeManager::ComputeOptimumTime(players[!playerID()].time(), turnNumber() / 2);
+
 	m_bStopMinimax = false;
-	m_ponderingFuture = std::async(std::launch::async, [this]()
+	m_ponderingFuture = std::async(std::launch::async, [this, ourMove, opponentTime]()
 	{
-#ifdef DEBUG_OUTPUT
-		cout << "Pondering" << endl;
-#endif
-		
-		// First search for the best opponent predicted move at a shallow depth
-		BoardMove predictedOpponentMove;
-		ApplyMove theirMove(m_bestMove, &m_board);
-		if(MiniMax(!playerID(), true, predictedOpponentMove))
-		{
-			if(!m_bStopMinimax)
-			{
-				// Signal that a best move has been found, and save the move
-				m_bestMoveMutex.lock();
-				m_opponentBestMove = predictedOpponentMove;
-				m_bFoundOpponentMove = true;
-				m_bestMoveMutex.unlock();
-				
-#ifdef DEBUG_OUTPUT
-				cout << endl;
-#endif
-				
-				// Search for my best move after applying the opponents best move
-				BoardMove myBestMove;
-				ApplyMove myMove(predictedOpponentMove, &m_board);
-				if(MiniMax(playerID(), false, myBestMove))
-				{
-					cout << "Found ponder move" << endl;
-					m_bestMove = myBestMove;
-				}
-			}
-		}
+		Ponder(ourMove, opponentTime);
 	});
 
 	return true;
@@ -156,269 +198,155 @@ bool AI::run()
 //This function is run once, after your last turn.
 void AI::end()
 {
-	m_bStopMinimax = true;
+	StopPondering();
+
+	unsigned int ponders = m_ponderHits + m_ponderMisses;
+	if(ponders > 0)
+	{
+		LOG_INFO("Ponder hit rate: {}/{} ({}%)", m_ponderHits, ponders, (100 * m_ponderHits) / ponders);
+		LOG_INFO("Ponder time saved: {}", m_ponderTimeSaved / 1000000000.0);
+	}
+
+	// The server messages which follow are written directly to standard output
+	FlushLog();
 }
 
-void AI::WaitForFuture(const std::future<void>& fut, bool bPondering)
+void AI::UpdateBoard()
 {
-	std::uint64_t timePerMove = GetTimePerMove();
-	if(bPondering)
+	std::vector<BoardPiece> boardPieces;
+	boardPieces.reserve(pieces.size());
+	for(const Piece& p : pieces)
 	{
-		timePerMove /= 2;
+		boardPieces.push_back({p.id(), p.owner(), p.file(), p.rank(), p.hasMoved(), p.type()});
 	}
 
-	// Wait until the thread finishes or it gets timed out
-	if(fut.wait_for(std::chrono::nanoseconds(timePerMove)) == std::future_status::timeout)
+	std::vector<BoardMove> boardMoves;
+	boardMoves.reserve(moves.size());
+	for(const Move& m : moves)
 	{
-		// If the thread did not finish execution, signal the thread to exit, and wait till the thread exits.
-	
-		m_bStopMinimax = true;
-		fut.wait();
-		m_bStopMinimax = false;
+		boardMoves.push_back(BoardMove({m.fromFile(), m.fromRank()}, {m.toFile(), m.toRank()}, 0, m.promoteType()));
 	}
+
+	m_board.Update(TurnsToStalemate(), boardMoves, boardPieces);
 }
 
-bool AI::MiniMax(int playerID, bool bCutDepth, BoardMove& moveOut)
+void AI::WaitForFuture(const std::future<void>& fut, std::atomic_bool& bStop)
 {
-	unsigned int d = 1;
-	unsigned int depthLimit = (bCutDepth ? 3 : m_depth);
-	bool bEnableCutoff = false;
-	bool bFoundMove = false;
-
-	m_bInCheckmate = false;
-	
-	Timer minimaxTimer;
-	minimaxTimer.Start();
-	
-	ClearHistory();
-
-	// Loop until the depth limit is reached, or a checkmate is found
-	while((d <= depthLimit) && (!m_bInCheckmate || (d != 2)))
+	// Wait until the thread finishes or it gets timed out
+	if(fut.wait_until(m_timeManager.GetDeadline()) == std::future_status::timeout)
 	{
-		bool bFoundAtDepth = MiniMax(d, playerID, moveOut, bEnableCutoff);
-		
-		if(bFoundAtDepth)
-		{
-#ifdef DEBUG_OUTPUT
-			cout << "Depth " << d << " time: " << minimaxTimer.GetTime() << endl;
-#endif
-			bEnableCutoff = true;
-			bFoundMove = true;
-		}
-		else
-		{
-#ifdef DEBUG_OUTPUT
-			cout << "No move was found at depth " << d << endl;
-#endif
-			break;
-		}
-
-		++d;
-	}
+		// If the thread did not finish execution, signal the thread to exit, and wait till the thread exits.
 	
-	return bFoundMove;
+		bStop = true;
+		fut.wait();
+		bStop = false;
+	}
 }
 
-bool AI::MiniMax(int depth, int playerID, BoardMove& moveOut, bool bEnableCutoff)
+void AI::Ponder(const BoardMove& ourMove, std::uint64_t opponentTime)
 {
-	bool bFoundMove = false;
-	BoardMove bestMove;
+	LOG_DEBUG("Pondering");
 
-	int alpha = std::numeric_limits<int>::min() + 1;
-	int beta = std::numeric_limits<int>::max();
+	Board board = m_board;
+	board.MakeMove(ourMove);
 
-	// Build a priority queue of the frontier nodes
-	FRONTIER_TYPE frontier = MoveOrdering(playerID);
+	// First score the opponent replies with a shallow search
+	Search prediction(board, m_transpositionTable, m_timeManager, m_bStopMinimax, PONDER_PREDICTION_DEPTH, m_randEngine());
+	prediction.SetHistory(m_history);
+	m_transpositionTable.NewSearch();
 
-	for(const BoardMove& currentMove : frontier)
-	{
-		if(bEnableCutoff && m_bStopMinimax)
-		{
-			bFoundMove = false;
-			break;
-		}
-	
-		ApplyMove theMove(currentMove, &m_board);
-		int val = MiniMax(depth - 1, playerID, !playerID, alpha, beta, bEnableCutoff);
+	// There is nothing to ponder if the opponent has no reply
+	std::vector<std::pair<int, BoardMove>> replies;
+	if(!prediction.ScoreRootMoves(PONDER_PREDICTION_DEPTH, !playerID(), replies) || replies.empty())
+		return;
 
-		// If the new move is better than the last
-		if(val > alpha)
-		{
-			alpha = val;
-			bestMove = currentMove;
-			bFoundMove = true;
+	// The softmax of the scores predicts how likely the opponent plays each reply
+	unsigned int maxCandidates = std::min(MAX_PONDER_CANDIDATES, std::max(std::thread::hardware_concurrency(), 1u));
+	std::vector<double> probabilities;
+	double total = 0.0;
 
-#ifdef DEBUG_OUTPUT
-			cout << val << endl;
-#endif
-		}
-	}
-
-	if(bFoundMove)
+	for(const auto& reply : replies)
 	{
-		m_history[playerID][GetHistoryTableIndex(bestMove.from)][GetHistoryTableIndex(bestMove.to)] += (depth * depth) + 1;
-		moveOut = bestMove;
+		probabilities.push_back(std::exp((reply.first - replies.front().first) / PONDER_TEMPERATURE));
+		total += probabilities.back();
 	}
 
-	return bFoundMove;
-}
-
-int AI::MiniMax(int depth, int playerID, int playerIDToMove, int alpha, int beta, bool bEnableCutoff)
-{
-	if(bEnableCutoff && m_bStopMinimax)
-		return 0;
-
-	// If a checkmate has been found, return a large number
-	if(m_board.IsInCheckmate(!playerID))
+	m_ponderMutex.lock();
+	if(!m_bStopMinimax)
 	{
-		m_bInCheckmate = true;
-		return 1000000;
+		for(unsigned int i = 0; (i < replies.size()) && (m_ponderCandidates.size() < maxCandidates); ++i)
+		{
+			double probability = probabilities[i] / total;
+			if((i > 0) && (probability < MIN_PONDER_PROBABILITY))
+				break;
+
+			std::unique_ptr<PonderCandidate> pCandidate(new PonderCandidate);
+			pCandidate->opponentMove = replies[i].second;
+			pCandidate->probability = probability;
+			pCandidate->bStop = false;
+			pCandidate->bHit = false;
+			pCandidate->searchStart = std::chrono::steady_clock::now();
+			pCandidate->bFoundMove = false;
+			pCandidate->bContinued = false;
+			pCandidate->history = prediction.GetHistory();
+
+			m_ponderCandidates.push_back(std::move(pCandidate));
+		}
 	}
+	m_ponderMutex.unlock();
 
-	// If a stalemate is found, return 0 which is neutral for both sides
-	if(m_board.IsInStalemate(!playerID))
-		return 0;
-
-	// If this is a leaf node
-	if(depth <= 0)
+	// Search our answer to each reply on its own thread.
+	// The most likely reply is searched until the opponent moves, the others get a share of the opponent's expected time that is weighted by their probability
+	std::vector<std::future<void>> futures;
+	for(auto& pCandidate : m_ponderCandidates)
 	{
-		// Initiate quiescent search
+		PonderCandidate* pPonder = pCandidate.get();
+		double timeShare = pPonder->probability / m_ponderCandidates.front()->probability;
+		unsigned int seed = m_randEngine();
 
-		// Get the heuristic value of the node
-		int stand_pat = m_board.GetWorth(playerID, ChessHeuristic());
-		
-		if(depth <= -2)
-			return stand_pat;					
-
-		if(playerID == playerIDToMove)
+		futures.push_back(std::async(std::launch::async, [this, &board, pPonder, timeShare, opponentTime, seed]()
 		{
-			if(stand_pat >= beta)
-			{
-				return stand_pat;
-			}
+			Search search(board, m_transpositionTable, m_timeManager, pPonder->bStop, m_depth, seed, &pPonder->bHit);
+			search.GetBoard().MakeMove(pPonder->opponentMove);
+			search.SetHistory(pPonder->history);
 
-			// See if we can do better than alpha
-			if(stand_pat > alpha)
-			{
-				alpha = stand_pat;
-			}
-		}
-		else
-		{
-			if(stand_pat <= alpha)
+			if(timeShare < 1.0)
 			{
-				return stand_pat;
+				search.SetDeadline(pPonder->searchStart + std::chrono::nanoseconds(std::uint64_t(opponentTime * timeShare)));
 			}
-			// See if we can do better than beta
-			if(stand_pat < beta)
-			{
-				beta = stand_pat;
-			}
-		}
-	}		
-
-	// Build a priority queue of the frontier nodes
-	FRONTIER_TYPE frontier = MoveOrdering(playerIDToMove);
-
-	BoardMove bestMove;
-	bool bFoundBestMove = false;
 
-	for(const BoardMove& currentMove : frontier)
-	{
-		// If we are applying Quiescence Search, only look at attacking moves
-		if(depth <= 0)
-		{
-			if((currentMove.capturedType == 0) && (currentMove.specialMove != SpecialMove::Promotion))
-			{
-				continue;
-			}
-		}
+			pPonder->bFoundMove = search.MiniMax(playerID(), false, pPonder->bestMove, false, true);
+			pPonder->bContinued = !search.IsPondering();
+			pPonder->history = search.GetHistory();
 
-		// Apply the move in the queue with the highest priority
-		ApplyMove theMove(currentMove, &m_board);
-		int score = MiniMax(depth - 1, playerID, !playerIDToMove, alpha, beta, bEnableCutoff);
-
-		if(playerID == playerIDToMove)
-		{
-			if(score >= beta)
-			{
-				m_history[playerIDToMove][GetHistoryTableIndex(currentMove.from)][GetHistoryTableIndex(currentMove.to)] += (depth * depth) + 1;
-				return score;
-			}
-			
-			if(score > alpha)
-			{
-				alpha = score;
-				bestMove = currentMove;
-				bFoundBestMove = true;
-			}			
-		}
-		else
-		{
-			if(score <= alpha)
-			{
-				m_history[playerIDToMove][GetHistoryTableIndex(currentMove.from)][GetHistoryTableIndex(currentMove.to)] += (depth * depth) + 1;
-				return score;
-			}
-			
-			if(score < beta)
-			{
-				beta = score;
-				bestMove = currentMove;
-				bFoundBestMove = true;
-			}
-		}
+			LOG_DEBUG("Pondered {} ({}): {} nodes", pPonder->opponentMove, pPonder->probability, search.GetNodes());
+		}));
 	}
 
-	if(bFoundBestMove)
+	for(auto& fut : futures)
 	{
-		m_history[playerIDToMove][GetHistoryTableIndex(bestMove.from)][GetHistoryTableIndex(bestMove.to)] += (depth * depth) + 1;
+		fut.wait();
 	}
-		
-	return (playerID == playerIDToMove) ? alpha : beta;
 }
 
-AI::FRONTIER_TYPE AI::MoveOrdering(int playerIDToMove)
+void AI::StopPondering()
 {
-	std::vector<BoardMove> moves = m_board.GetMoves(playerIDToMove);
-	std::shuffle(moves.begin(), moves.end(), m_randEngine);
-
-	std::sort(moves.begin(), moves.end(), [&](const BoardMove& a, const BoardMove& b) -> bool
-	{
-		return (m_history[playerIDToMove][GetHistoryTableIndex(a.from)][GetHistoryTableIndex(a.to)]) >
-			   (m_history[playerIDToMove][GetHistoryTableIndex(b.from)][GetHistoryTableIndex(b.to)]);
-	});
-
-	return moves;
-}
-
-std::uint64_t AI::GetTimePerMove()
-{
-	std::uint64_t time = (std::uint64_t)players[playerID()].time() / 50 * 1000000000;
-
-	// If the game is almost going to time out,
-	// do not search as deep
-	if(time < 1)
+	m_ponderMutex.lock();
+	m_bStopMinimax = true;
+	for(auto& pCandidate : m_ponderCandidates)
 	{
-		m_depth = 4;
-		time = std::numeric_limits<std::uint64_t>::max();
+		pCandidate->bStop = true;
 	}
-
-	return time;
-}
-
-void AI::ClearHistory()
-{
-	std::memset(m_history.data(), 0, sizeof(m_history));
+	m_ponderMutex.unlock();
 }
 
 void AI::DrawBoard() const
 {
-	// Print out the current board state
-	cout<<"+---+---+---+---+---+---+---+---+"<<endl;
+	// Print out the current board state, one rank per message
+	LOG_DEBUG("+---+---+---+---+---+---+---+---+");
 	for(int rank=8; rank>0; rank--)
 	{
-		cout<<"|";
+		std::string line = "|";
 		for(int file=1; file<=8; file++)
 		{
 			bool found = false;
@@ -432,23 +360,25 @@ void AI::DrawBoard() const
 					// Checks if the piece is black
 					if(pieces[p].owner() == 1)
 					{
-						cout<<"*";
+						line += "*";
 					}
 					else
 					{
-						cout<<" ";
+						line += " ";
 					}
 					// prints the piece's type
-					cout<<(char)pieces[p].type()<<" ";
+					line += (char)pieces[p].type();
+					line += " ";
 				}
 			}
 
 			if(!found)
 			{
-				cout<<"   ";
+				line += "   ";
 			}
-			cout<<"|";
+			line += "|";
 		}
-		cout<<endl<<"+---+---+---+---+---+---+---+---+"<<endl;
+		LOG_DEBUG("{}", line);
+		LOG_DEBUG("+---+---+---+---+---+---+---+---+");
 	}
 }
@@ -4,6 +4,9 @@
 #include "BaseAI.h"
 #include "Board.h"
 #include "Timer.h"
+#include "TimeManager.h"
+#include "TranspositionTable.h"
+#include "Search.h"
 #include <random>
 #include <array>
 #include <queue>
@@ -11,15 +14,13 @@
 #include <atomic>
 #include <mutex>
 #include <future>
+#include <memory>
 
 ///The class implementing gameplay logic.
 class AI: public BaseAI
 {
 public:
 
-  typedef std::array<std::array<std::array<int,64>,64>,2> HISTORY_ARRAY_TYPE;
-  typedef std::vector<BoardMove> FRONTIER_TYPE;
-
   AI(Connection* c, unsigned int depth);
   virtual const char* username();
   virtual const char* password();
@@ -29,43 +30,66 @@ public:
 
 private:
 
-  // Waits for GetTimePerMove() on the future.
-  // If bPondering is true, GetTimePerMove() is cut in half.
-  void WaitForFuture(const std::future<void>& fut, bool bPondering = false);
+  // Search of our reply to one of the predicted opponent moves
+  struct PonderCandidate
+  {
+    BoardMove opponentMove;
+
+    // Probability that the opponent plays the move
+    double probability;
+
+    std::atomic_bool bStop;
+    std::atomic_bool bHit;
+    std::chrono::steady_clock::time_point searchStart;
+
+    // Results of the search, valid once the pondering thread finished
+    BoardMove bestMove;
+    bool bFoundMove;
 
-  // Finds the best move from minimax with alpha beta pruning, Quiescence Search, and History Table
-  bool MiniMax(int playerID, bool bCutTime, BoardMove& moveOut);
-  bool MiniMax(int depth, int playerID, BoardMove& moveOut, bool bEnableCutoff);
-  int MiniMax(int depth, int playerID, int playerIDToMove, int a, int b, bool bEnableCutoff);
+    // True if the search was still running when the hit was signaled, so it continued as the search of the turn
+    bool bContinued;
 
-  // Returns the frontier nodes for the current player to move sorted from high to low based on the history table
-  FRONTIER_TYPE MoveOrdering(int playerIDToMove);
+    Search::HistoryTable history;
+  };
 
-  // Returns the amount of time that the AI has per turn
-  std::uint64_t GetTimePerMove();
-  
-  // Clears all entries in the history table
-  void ClearHistory();
+  // Refills the board with the pieces and moves received from the server
+  void UpdateBoard();
 
-  // Draws the chess board to standard output
+  // Waits on the future until the hard limit of the time manager is reached, then raises bStop and waits till the thread exits.
+  void WaitForFuture(const std::future<void>& fut, std::atomic_bool& bStop);
+
+  // Predicts the most likely opponent replies to our move, then searches our answer to each of them on its own thread.
+  // opponentTime is the time the opponent is expected to use for the reply in nanoseconds
+  void Ponder(const BoardMove& ourMove, std::uint64_t opponentTime);
+
+  // Raises the stop flags of the pondering searches
+  void StopPondering();
+
+  // Draws the chess board to the log
   void DrawBoard() const;
 
 private:
 
   Board m_board;
+  TimeManager m_timeManager;
+  TranspositionTable m_transpositionTable;
   std::uint64_t m_totalTime;
   unsigned int m_count;
   unsigned int m_depth;
-  bool m_bInCheckmate;
 
-  std::mutex m_bestMoveMutex;
+  std::mutex m_ponderMutex;
   std::atomic_bool m_bStopMinimax;
   BoardMove m_bestMove;
-  BoardMove m_opponentBestMove;
-  bool m_bFoundOpponentMove;
+  std::vector<std::unique_ptr<PonderCandidate>> m_ponderCandidates;
   std::future<void> m_ponderingFuture;
 
-  HISTORY_ARRAY_TYPE m_history;
+  // Pondering statistics of the game
+  unsigned int m_ponderHits;
+  unsigned int m_ponderMisses;
+  std::uint64_t m_ponderTimeSaved;
+
+  // History table carried from one search to the next, each search ages it before use
+  Search::HistoryTable m_history;
 
   std::default_random_engine m_randEngine;
 };
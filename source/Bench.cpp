@@ -0,0 +1,122 @@
+#include "Bench.h"
+#include "Board.h"
+#include "Log.h"
+#include "Search.h"
+#include "SearchStats.h"
+#include "Timer.h"
+#include "TranspositionTable.h"
+#include <atomic>
+#include <iomanip>
+
+// Openings, middlegames and endgames with tactics, castling rights and en passant captures
+static const char* const BENCH_POSITIONS[] =
+{
+	"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+	"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 10",
+	"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 11",
+	"4rrk1/pp1n3p/3q2pQ/2p1pb2/2PP4/2P3N1/P2B2PP/4RRK1 b - - 7 19",
+	"rq3rk1/ppp2ppp/1bnpb3/3N2B1/3NP3/7P/PPPQ1PP1/2KR3R w - - 7 14",
+	"r1bq1r1k/1pp1n1pp/1p1p4/4p2Q/4Pp2/1BNP4/PPP2PPP/3R1RK1 w - - 2 14",
+	"r3r1k1/2p2ppp/p1p1bn2/8/1q2P3/2NPQN2/PPP3PP/R4RK1 b - - 2 15",
+	"r1bbk1nr/pp3p1p/2n5/1N4p1/2Np1B2/8/PPP2PPP/2KR1B1R w kq - 0 13",
+	"r1bq1rk1/ppp1nppp/4n3/3p3Q/3P4/1BP1B3/PP1N2PP/R4RK1 w - - 1 16",
+	"4r1k1/r1q2ppp/ppp2n2/4P3/5Rb1/1N1BQ3/PPP3PP/R5K1 w - - 1 17",
+	"2rqkb1r/ppp2p2/2npb1p1/1N1Nn2p/2P1PP2/8/PP2B1PP/R1BQK2R b KQ - 0 11",
+	"r1bq1r1k/b1p1npp1/p2p3p/1p6/3PP3/1B2NN2/PP3PPP/R2Q1RK1 w - - 1 16",
+	"3r1rk1/p5pp/bpp1pp2/8/q1PP1P2/b3P3/P2NQRPP/1R2B1K1 b - - 6 22",
+	"r1q2rk1/2p1bppp/2Pp4/p6b/Q1PNp3/4B3/PP1R1PPP/2K4R w - - 2 18",
+	"4k2r/1pb2ppp/1p2p3/1R1p4/3P4/2r1PN2/P4PPP/1R4K1 b - - 3 22",
+	"3q2k1/pb3p1p/4pbp1/2r5/PpN2N2/1P2P2P/5PP1/Q2R2K1 b - - 4 26",
+	"rnbqkb1r/ppp1pppp/5n2/3pP3/8/8/PPPP1PPP/RNBQKBNR w KQkq d6 0 3",
+	"r1bqkbnr/pppp1ppp/2n5/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R b KQkq - 3 3",
+	"rnbqk2r/pppp1ppp/5n2/2b1p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4",
+	"r1bqk2r/pppp1ppp/2n2n2/2b1p3/2B1P3/2NP1N2/PPP2PPP/R1BQK2R b KQkq - 0 5",
+	"6k1/6p1/6Pp/ppp5/3pn2P/1P3K2/1PP2P2/3N4 b - - 0 1",
+	"3b4/5kp1/1p1p1p1p/pP1PpP1P/P1P1P3/3KN3/8/8 w - - 0 1",
+	"2K5/p7/7P/5pR1/8/5k2/r7/8 w - - 0 1",
+	"8/6pk/1p6/8/PP3p1p/5P2/4KP1q/3Q4 w - - 0 1",
+	"7k/3p2pp/4q3/8/4Q3/5Kp1/P6b/8 w - - 0 1",
+	"8/2p5/8/2kPKp1p/2p4P/2P5/3P4/8 w - - 0 1",
+	"8/1p3pp1/7p/5P1P/2k3P1/8/2K2P2/8 w - - 0 1",
+	"8/pp2r1k1/2p1p3/3pP2p/1P1P1P1P/P5KR/8/8 w - - 0 1",
+	"8/3p4/p1bk3p/Pp6/1Kp1PpPp/2P2P1P/2P5/5B2 b - - 0 1",
+	"5k2/7R/4P2p/5K2/p1r2P1p/8/8/8 b - - 0 1",
+	"6k1/6p1/P6p/r1N5/5p2/7P/1b3PP1/4R1K1 w - - 0 1",
+	"1r3k2/4q3/2Pp3b/3Bp3/2Q2p2/1p1P2P1/1P2KP2/3N4 w - - 0 1",
+	"6k1/4pp1p/3p2p1/P1pPb3/R7/1r2P1PP/3B1P2/6K1 w - - 0 1",
+	"8/3p3B/5p2/5P2/p7/PP5b/k7/6K1 w - - 0 1",
+	"8/8/8/8/5kp1/P7/8/1K1N4 w - - 0 1",
+	"8/8/8/5N2/8/p7/8/2NK3k w - - 0 1",
+	"8/3k4/8/8/8/4B3/4KB2/2B5 w - - 0 1",
+	"8/8/1P6/5pr1/8/4R3/7k/2K5 w - - 0 1",
+	"8/2p4P/8/kr6/6R1/8/8/1K6 w - - 0 1",
+	"6k1/3b3r/1p1p4/p1n2p2/1PPNpP1q/P3Q1p1/1R1RB1P1/5K2 b - - 0 1",
+};
+
+// Every search of the bench shuffles its moves with the same seed
+static const unsigned int BENCH_SEED = 1;
+
+// Mixes a value into the signature with the FNV-1a prime
+static std::uint64_t MixSignature(std::uint64_t signature, std::uint64_t value)
+{
+	return (signature ^ value) * 1099511628211ull;
+}
+
+bool RunBench(unsigned int depth, std::ostream& stream)
+{
+	// Only the results of the bench are written, the log and statistics of the searches would slow it down
+	SetLogStream(nullptr);
+	SetSearchStatsEnabled(false);
+
+	TranspositionTable transpositionTable;
+	std::atomic_bool bStop(false);
+
+	SearchLimits limits;
+	limits.depth = depth;
+
+	std::uint64_t totalNodes = 0;
+	std::uint64_t signature = 14695981039346656037ull;
+	unsigned int positionCount = sizeof(BENCH_POSITIONS) / sizeof(BENCH_POSITIONS[0]);
+
+	Timer timer;
+	timer.Start();
+
+	for(unsigned int i = 0; i < positionCount; ++i)
+	{
+		Board board;
+		int playerIDToMove = 0;
+		if(!board.LoadFEN(BENCH_POSITIONS[i], playerIDToMove))
+		{
+			stream << "Invalid bench position: " << BENCH_POSITIONS[i] << std::endl;
+			return false;
+		}
+
+		// Each position starts from an empty table, so the results do not depend on the positions searched before it
+		transpositionTable.Clear();
+
+		Search search(board, transpositionTable, bStop, BENCH_SEED);
+		BoardMove bestMove;
+		bool bFoundMove = search.Run(playerIDToMove, limits, bestMove);
+
+		totalNodes += search.GetNodes();
+		signature = MixSignature(signature, search.GetNodes());
+		if(bFoundMove)
+		{
+			signature = MixSignature(signature, (bestMove.from.x << 12) | (bestMove.from.y << 8) | (bestMove.to.x << 4) | bestMove.to.y);
+		}
+
+		// The move ends the line
+		stream << "Position " << (i + 1) << "/" << positionCount << ": " << search.GetNodes() << " nodes, best move " << bestMove;
+	}
+
+	std::uint64_t time = timer.GetTime();
+
+	stream << "===========================" << std::endl;
+	stream << "Depth           : " << depth << std::endl;
+	stream << "Total time (ms) : " << time / 1000000 << std::endl;
+	stream << "Nodes searched  : " << totalNodes << std::endl;
+	stream << "Signature       : " << std::hex << std::setw(16) << std::setfill('0') << signature << std::dec << std::endl;
+	stream << "Nodes/second    : " << ((time > 0) ? std::uint64_t(totalNodes * 1000000000.0 / time) : 0) << std::endl;
+
+	return true;
+}
@@ -0,0 +1,14 @@
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+#include <ostream>
+
+// Depth that the bench positions are searched to by default
+static const unsigned int DEFAULT_BENCH_DEPTH = 5;
+
+// Searches every built in bench position to the depth with a fixed seed, then writes the total nodes, their signature and the speed to the stream.
+// The node counts only change when the search changes, so the signature identifies the behavior of a build and the speed can be compared between builds.
+// Returns false if a position could not be loaded
+bool RunBench(unsigned int depth, std::ostream& stream);
+
+#endif // _BENCH_H_
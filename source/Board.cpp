@@ -2,326 +2,437 @@
 #include <algorithm>
 #include <iostream>
 #include <cassert>
+#include <cctype>
+#include <cstring>
+#include <random>
+#include <sstream>
 
 using std::cout;
 using std::endl;
 
-bool operator ==(const BoardPiece& a, const BoardPiece& b)
+// Returns the index of the tile from 0 to 63
+static unsigned int GetTileIndex(const ivec2& pos)
 {
-	return (a.type == b.type) && (a.hasMoved == b.hasMoved) && (a.owner == b.owner);
+	return (8*(pos.x - 1) + (pos.y - 1));
 }
 
-ApplyMove::ApplyMove(const BoardMove& move, Board* pBoard) : m_move(move), m_pBoard(pBoard)
+// Returns the bit of the tile in a 64 bit tile mask
+static std::uint64_t GetTileMask(const ivec2& pos)
 {
-	// todo: clean up this code
-	assert(pBoard != nullptr);
-
-	BoardPiece* pFrom = m_pBoard->GetPiece(m_move.from);
-	assert(pFrom != nullptr);
-
-	m_pBoard->m_moveHistory.push_front(m_move);
-
-	m_newIndex = m_pBoard->m_board[m_move.to.x - 1][m_move.to.y - 1];
-
-	m_pBoard->m_board[m_move.to.x - 1][m_move.to.y - 1] = 0;
-	std::swap(m_pBoard->m_board[m_move.from.x - 1][m_move.from.y - 1],
-			  m_pBoard->m_board[m_move.to.x - 1][m_move.to.y - 1]);
-
-	m_LastMove = m_pBoard->m_LastMove;
-	m_pBoard->m_LastMove = m_move;
-
-	pFrom->file = m_move.to.x;
-	pFrom->rank = m_move.to.y;
-
-	m_hasMoved = pFrom->hasMoved;
-	pFrom->hasMoved = 1;
+	return std::uint64_t(1) << GetTileIndex(pos);
+}
 
-	// Turns left for stalemate logic
-	if((m_move.capturedType == 0) && (pFrom->type != 'P'))
-	{
-		m_pBoard->m_turnsToStalemate--;
-	}
-	else
-	{
-		m_oldTurnsToStalemate = m_pBoard->m_turnsToStalemate;
-		m_pBoard->m_turnsToStalemate = 100;
-	}
-	
-	if(m_move.capturedType != 0)
+// Random keys used to hash positions
+struct ZobristKeys
+{
+	ZobristKeys()
 	{
-		m_pBoard->m_piecesCount[!pFrom->owner]--;
-		
-		// Update the number of knights and bishops
-		if(m_move.capturedType == 'N')
+		// A fixed seed keeps the keys identical between runs
+		std::mt19937_64 engine(20140101);
+
+		for(auto& owner : pieces)
 		{
-			m_pBoard->m_knightCounter[!pFrom->owner]--;
+			for(auto& type : owner)
+			{
+				for(std::uint64_t& key : type)
+				{
+					key = engine();
+				}
+			}
 		}
-		else if(m_move.capturedType == 'B')
+
+		blackToMove = engine();
+
+		for(auto& owner : castling)
 		{
-			m_pBoard->m_bishopCounter[!pFrom->owner]--;
+			for(std::uint64_t& key : owner)
+			{
+				key = engine();
+			}
 		}
-		else if(m_move.capturedType == 'Q')
+
+		for(std::uint64_t& key : enPassantFile)
 		{
-			m_pBoard->m_hasQueen[!pFrom->owner] = false;
+			key = engine();
 		}
 	}
-	
-	if(pFrom->type == 'K') // Keep track of the kings
-	{
-		m_oldKingPos = m_pBoard->m_kingPos[pFrom->owner];
-		m_pBoard->m_kingPos[pFrom->owner] = m_move.to;
-	}
-	
-	// Promotion logic
-	else if(m_move.specialMove == SpecialMove::Promotion)
+
+	std::uint64_t pieces[2][6][64];
+	std::uint64_t blackToMove;
+
+	// Keys of the castling rights of each player, the queen side first
+	std::uint64_t castling[2][2];
+
+	// Keys of the file of a pawn which can be captured en passant
+	std::uint64_t enPassantFile[8];
+};
+
+static const ZobristKeys s_zobristKeys;
+
+// Returns the key of a piece standing on the tile
+static std::uint64_t GetPieceKey(int owner, int type, const ivec2& pos)
+{
+	unsigned int typeIndex = 0;
+	switch(type)
 	{
-		m_type = pFrom->type;
-		pFrom->type = m_move.promotion;
-		
-		// Update the number of knights and bishops upon promotion
-		if(m_move.promotion == 'N')
-		{
-			m_pBoard->m_knightCounter[!pFrom->owner]++;
-		}
-		else if(m_move.promotion == 'B')
-		{
-			m_pBoard->m_bishopCounter[!pFrom->owner]++;
-			m_pBoard->m_bishopPos[!pFrom->owner] = m_move.to;
-		}
+		case 'P':
+			typeIndex = 0;
+			break;
+		case 'N':
+			typeIndex = 1;
+			break;
+		case 'B':
+			typeIndex = 2;
+			break;
+		case 'R':
+			typeIndex = 3;
+			break;
+		case 'Q':
+			typeIndex = 4;
+			break;
+		case 'K':
+			typeIndex = 5;
+			break;
+		default:
+			assert("Invalid piece type" && false);
 	}
-	else if(m_move.specialMove == SpecialMove::Castle)
+
+	return s_zobristKeys.pieces[owner][typeIndex][GetTileIndex(pos)];
+}
+
+// Returns the material value of a piece type used when exchanging pieces
+static int GetExchangeValue(int type)
+{
+	switch(type)
 	{
-		ApplyCastleMove(true);
+		case 'P':
+			return 100;
+		case 'N':
+			return 320;
+		case 'B':
+			return 330;
+		case 'R':
+			return 550;
+		case 'Q':
+			return 900;
+		case 'K':
+			return 20000;
+		default:
+			return 0;
 	}
 }
 
+bool operator ==(const BoardPiece& a, const BoardPiece& b)
+{
+	return (a.type == b.type) && (a.hasMoved == b.hasMoved) && (a.owner == b.owner);
+}
+
+ApplyMove::ApplyMove(const BoardMove& move, Board* pBoard) : m_move(move), m_pBoard(pBoard)
+{
+	assert(pBoard != nullptr);
+	m_pBoard->MakeMove(m_move);
+}
+
 ApplyMove::~ApplyMove()
 {
-	// todo: clean up this code
-	BoardPiece* pFrom = m_pBoard->GetPiece(m_move.to);
-	assert(pFrom != nullptr);
+	m_pBoard->UnmakeMove(m_move);
+}
 
-	m_pBoard->m_moveHistory.pop_front();
+Board::Board() : m_hash(0), m_rootHashIndex(0), m_turnsToStalemate(0)
+{
+	m_stateStack.reserve(256);
+	m_board.resize(8);
 
-	// Keep track of the kings
-	if(pFrom->type == 'K')
-	{
-		m_pBoard->m_kingPos[pFrom->owner] = m_oldKingPos;
-	}
-	// Promotion logic
-	else if(m_move.specialMove == SpecialMove::Promotion)
-	{
-		pFrom->type = m_type;
-		
-		// Update the number of knights and bishops upon promotion
-		if(m_move.promotion == 'N')
-		{
-			m_pBoard->m_knightCounter[!pFrom->owner]--;
-		}
-		else if(m_move.promotion == 'B')
-		{
-			m_pBoard->m_bishopCounter[!pFrom->owner]--;
-		}
-	}
-	else if(m_move.specialMove == SpecialMove::Castle)
+	for(auto& iter : m_board)
 	{
-		ApplyCastleMove(false);
+		iter.resize(8);
 	}
+}
 
-	// Turns left for stalemate logic
-	if((m_move.capturedType == 0) && (pFrom->type != 'P'))
+void Board::Update(int turnsToStalemate, const std::vector<BoardMove>& moves, const std::vector<BoardPiece>& pieces)
+{
+	// Clear the old board
+	Clear();
+
+	// Fill new board with pieces
+	for(const BoardPiece& piece : pieces)
 	{
-		m_pBoard->m_turnsToStalemate++;
+		AddPiece(piece);
 	}
-	else
+
+	if(!moves.empty())
 	{
-		m_pBoard->m_turnsToStalemate = m_oldTurnsToStalemate;
+		const ivec2& from = moves[0].from;
+		const ivec2& to = moves[0].to;
+
+		// The last move can only be captured en passant if it was a pawn moving two tiles
+		if((abs(to.y - from.y) == 2) && (GetPieceType(to) == 'P'))
+		{
+			m_enPassantPos = to;
+		}
 	}
-	
-	if(m_move.capturedType != 0)
+
+	m_turnsToStalemate = turnsToStalemate;
+
+	UpdateHashHistory(moves);
+}
+
+bool Board::LoadFEN(const std::string& fen, int& playerIDToMoveOut)
+{
+	std::istringstream stream(fen);
+	std::string placement;
+	std::string side;
+	std::string castling = "-";
+	std::string enPassant = "-";
+	int halfMoveClock = 0;
+
+	stream >> placement >> side >> castling >> enPassant >> halfMoveClock;
+
+	if(placement.empty() || ((side != "w") && (side != "b")))
+		return false;
+
+	Clear();
+
+	int id = 1;
+	int kings[2] = {0, 0};
+	ivec2 pos = {1, 8};
+
+	for(char c : placement)
 	{
-		m_pBoard->m_piecesCount[!pFrom->owner]++;
-		
-		// Update the number of knights and bishops
-		if(m_move.capturedType == 'N')
+		if(c == '/')
 		{
-			m_pBoard->m_knightCounter[!pFrom->owner]++;
+			pos = {1, pos.y - 1};
 		}
-		else if(m_move.capturedType == 'B')
+		else if(std::isdigit(c))
 		{
-			m_pBoard->m_bishopCounter[!pFrom->owner]++;
+			pos.x += c - '0';
 		}
-		else if(m_move.capturedType == 'Q')
+		else
 		{
-			m_pBoard->m_hasQueen[!pFrom->owner] = true;
+			int type = std::toupper(c);
+			if(!IsOnBoard(pos) || (std::strchr("KQRBNP", type) == nullptr))
+				return false;
+
+			BoardPiece piece = {id++, std::isupper(c) ? 0 : 1, pos.x, pos.y, 1, type};
+			int homeRank = (piece.owner == 0) ? 1 : 8;
+
+			// Pawns on their starting rank, and kings and rooks which can still castle have not moved
+			if(type == 'P')
+			{
+				piece.hasMoved = (pos.y != ((piece.owner == 0) ? 2 : 7));
+			}
+			else if(type == 'K')
+			{
+				const char* rights = (piece.owner == 0) ? "KQ" : "kq";
+				bool bCanCastle = (castling.find(rights[0]) != std::string::npos) || (castling.find(rights[1]) != std::string::npos);
+				piece.hasMoved = !bCanCastle || (pos != ivec2{5, homeRank});
+				++kings[piece.owner];
+			}
+			else if((type == 'R') && (pos.y == homeRank) && ((pos.x == 1) || (pos.x == 8)))
+			{
+				char right = (pos.x == 8) ? 'K' : 'Q';
+				if(piece.owner == 1)
+				{
+					right = std::tolower(right);
+				}
+
+				piece.hasMoved = (castling.find(right) == std::string::npos);
+			}
+
+			AddPiece(piece);
+			++pos.x;
 		}
 	}
 
-	std::swap(m_pBoard->m_board[m_move.from.x - 1][m_move.from.y - 1],
-			  m_pBoard->m_board[m_move.to.x - 1][m_move.to.y - 1]);
+	if((kings[0] != 1) || (kings[1] != 1))
+		return false;
+
+	// The en passant field names the tile behind the pawn which can be captured
+	if((enPassant.size() == 2) && (enPassant[0] >= 'a') && (enPassant[0] <= 'h') && ((enPassant[1] == '3') || (enPassant[1] == '6')))
+	{
+		m_enPassantPos = {enPassant[0] - 'a' + 1, (enPassant[1] == '3') ? 4 : 5};
+	}
 
-	m_pBoard->m_board[m_move.to.x - 1][m_move.to.y - 1] = m_newIndex;
+	playerIDToMoveOut = (side == "w") ? 0 : 1;
+	m_turnsToStalemate = std::max(100 - halfMoveClock, 0);
 
-	m_pBoard->m_LastMove = m_LastMove;
+	// Without the moves of the game there is no history to rebuild
+	m_hash = ComputeHash(playerIDToMoveOut);
+	m_hashHistory.assign(1, m_hash);
+	m_rootHashIndex = 0;
 
-	pFrom->file = m_move.from.x;
-	pFrom->rank = m_move.from.y;
-	pFrom->hasMoved = m_hasMoved;
+	return true;
 }
 
-void ApplyMove::ApplyCastleMove(bool bApply)
+std::vector<BoardMove> Board::GetMoves(int playerID)
 {
-	int rookFile = 1;
-	int rookToFile = 4;
+	return GetMoves(playerID, true);
+}
+
+void Board::MakeMove(const BoardMove& move)
+{
+	BoardPiece* pFrom = GetPiece(move.from);
+	assert(pFrom != nullptr);
+
+	int owner = pFrom->owner;
+	int type = (move.specialMove == SpecialMove::Promotion) ? move.promotion : pFrom->type;
 
-	if((m_move.to.x - m_move.from.x) > 0)
+	// The captured pawn is beside the destination tile when capturing en passant
+	ivec2 capturedPos = move.to;
+	if(move.specialMove == SpecialMove::EnPassant)
 	{
-		// Rook will move to the left
-		rookFile = 8;
-		rookToFile = 6;
+		capturedPos.y = move.from.y;
 	}
 
-	if(!bApply)
+	m_stateStack.push_back(StateInfo());
+	StateInfo& state = m_stateStack.back();
+	state.capturedID = m_board[capturedPos.x - 1][capturedPos.y - 1];
+	state.capturedPos = capturedPos;
+	state.hasMoved = pFrom->hasMoved;
+	state.enPassantPos = m_enPassantPos;
+	state.turnsToStalemate = m_turnsToStalemate;
+	state.hash = m_hash;
+
+	// Castling rights only change when a king or rook moves for the first time or an unmoved rook is captured
+	const BoardPiece* pCaptured = (state.capturedID != 0) ? GetPiece(state.capturedID) : nullptr;
+	bool bCastlingChange = (!pFrom->hasMoved && ((pFrom->type == 'K') || (pFrom->type == 'R'))) ||
+						   ((pCaptured != nullptr) && (pCaptured->type == 'R') && !pCaptured->hasMoved);
+	if(bCastlingChange)
 	{
-		std::swap(rookFile, rookToFile);
+		m_hash ^= GetCastlingKey(0, m_board, std::vector<int>()) ^ GetCastlingKey(1, m_board, std::vector<int>());
 	}
 
-	BoardPiece* pRook = m_pBoard->GetPiece({rookFile,m_move.from.y});
-	assert(pRook != nullptr);
+	m_hash ^= GetEnPassantKey(m_enPassantPos, m_board);
+	m_hash ^= s_zobristKeys.blackToMove;
+	m_hash ^= GetPieceKey(owner, pFrom->type, move.from) ^ GetPieceKey(owner, type, move.to);
 
-	pRook->file = rookToFile;
-	pRook->hasMoved = bApply;
+	if(pCaptured != nullptr)
+	{
 
-	std::swap(m_pBoard->m_board[rookFile - 1][m_move.from.y - 1], m_pBoard->m_board[rookToFile - 1][m_move.from.y - 1]);
-}
+		m_hash ^= GetPieceKey(pCaptured->owner, pCaptured->type, capturedPos);
+		m_board[capturedPos.x - 1][capturedPos.y - 1] = 0;
 
-void BoardHash::SetBoard(const Board* pBoard)
-{
-	s_pBoard = pBoard;
-}
+		m_piecesCount[pCaptured->owner]--;
+		UpdateMinorPieceCounters(pCaptured->owner, pCaptured->type, -1);
 
-std::size_t BoardHash::operator()(const std::vector<std::vector<int>>& key) const
-{
-	std::size_t h = 5381;
-	for(const auto& iter : key)
-	{
-		for(int i : iter)
+		if(pCaptured->type == 'Q')
 		{
-			int c = '0';
-			const BoardPiece* pPiece = s_pBoard->GetPiece(i);
-			if(pPiece != nullptr)
-			{
-				c = pPiece->type;
-			}
-			
-			h ^= c + 0x9e3779b9 + (h<<6) + (h>>2);
+			m_hasQueen[pCaptured->owner] = false;
 		}
 	}
 
-	return h;
-}
+	// Turns left for stalemate logic
+	if((state.capturedID == 0) && (pFrom->type != 'P'))
+	{
+		m_turnsToStalemate--;
+	}
+	else
+	{
+		m_turnsToStalemate = 100;
+	}
+
+	m_enPassantPos = ivec2();
+	if((pFrom->type == 'P') && (abs(move.to.y - move.from.y) == 2))
+	{
+		m_enPassantPos = move.to;
+	}
 
-const Board* BoardHash::s_pBoard = nullptr;
+	std::swap(m_board[move.from.x - 1][move.from.y - 1], m_board[move.to.x - 1][move.to.y - 1]);
 
-void BoardEqual::SetBoard(const Board* pBoard)
-{
-	s_pBoard = pBoard;
-}
+	pFrom->file = move.to.x;
+	pFrom->rank = move.to.y;
+	pFrom->hasMoved = 1;
 
-bool BoardEqual::operator()(const std::vector<std::vector<int>>& a, const std::vector<std::vector<int>>& b) const
-{
-	return std::equal(a.begin(), a.end(), b.begin(), [this](const std::vector<int>& subA, const std::vector<int>& subB) -> bool
+	if(pFrom->type == 'K') // Keep track of the kings
 	{
-		return std::equal(subA.begin(), subA.end(), subB.begin(), [this](int idA, int idB) -> bool
-		{
-			if((idA == 0) && (idB == 0))
-				return true;
-			
-			const BoardPiece* pPieceA = s_pBoard->GetPiece(idA);
-			const BoardPiece* pPieceB = s_pBoard->GetPiece(idB);
-			
-			if(pPieceA == nullptr || pPieceB == nullptr)
-				return false;
-			
-			return (*pPieceA) == (*pPieceB);
-		});
-	});
-}
+		m_kingPos[owner] = move.to;
 
-const Board* BoardEqual::s_pBoard = nullptr;
+		if(move.specialMove == SpecialMove::Castle)
+		{
+			MoveCastleRook(move, true);
+		}
+	}
+	else if(pFrom->type == 'B')
+	{
+		m_bishopPos[owner] = move.to;
+	}
+	else if(move.specialMove == SpecialMove::Promotion)
+	{
+		// The position of a promoted bishop is only needed if it is the only bishop
+		if((type == 'B') && (m_bishopCounter[owner] == 0))
+		{
+			m_bishopPos[owner] = move.to;
+		}
 
-Board::Board() : m_turnsToStalemate(0)
-{
-	BoardHash::SetBoard(this);
-	BoardEqual::SetBoard(this);
-	
-	m_board.resize(8);
+		pFrom->type = type;
+		UpdateMinorPieceCounters(owner, type, 1);
+	}
 
-	for(auto& iter : m_board)
+	if(bCastlingChange)
 	{
-		iter.resize(8);
+		m_hash ^= GetCastlingKey(0, m_board, std::vector<int>()) ^ GetCastlingKey(1, m_board, std::vector<int>());
 	}
+
+	m_hash ^= GetEnPassantKey(m_enPassantPos, m_board);
+
+	m_hashHistory.push_back(m_hash);
 }
 
-void Board::Update(int turnsToStalemate, const std::vector<Move>& moves, const std::vector<Piece>& pieces)
+void Board::UnmakeMove(const BoardMove& move)
 {
-	// Clear the old board
-	Clear();
+	assert(!m_stateStack.empty());
+	const StateInfo& state = m_stateStack.back();
 
-	// Fill new board with pieces
-	for(const Piece& p : pieces)
+	BoardPiece* pFrom = GetPiece(move.to);
+	assert(pFrom != nullptr);
+
+	if(pFrom->type == 'K')
 	{
-		// Count of pieces on the board
-		m_piecesCount[p.owner()]++;
-		
-		// Cache locations of bishops and kings and count the number of knights and bishops
-		switch(p.type())
+		m_kingPos[pFrom->owner] = move.from;
+
+		if(move.specialMove == SpecialMove::Castle)
 		{
-			case 'N':
-				m_knightCounter[p.owner()]++;
-				break;
-			case 'B':
-				m_bishopCounter[p.owner()]++;
-				m_bishopPos[p.owner()] = {p.file(), p.rank()};
-				break;
-			case 'Q':
-				m_hasQueen[p.owner()] = true;
-				break;
-			case 'K':
-				m_kingPos[p.owner()] = {p.file(), p.rank()};
-				break;
-			default:
-				break;
+			MoveCastleRook(move, false);
 		}
+	}
+	else if(move.specialMove == SpecialMove::Promotion)
+	{
+		UpdateMinorPieceCounters(pFrom->owner, pFrom->type, -1);
+		pFrom->type = 'P';
+	}
+	else if(pFrom->type == 'B')
+	{
+		m_bishopPos[pFrom->owner] = move.from;
+	}
 
-		unsigned int index = p.id();
+	std::swap(m_board[move.from.x - 1][move.from.y - 1], m_board[move.to.x - 1][move.to.y - 1]);
 
-		m_board[p.file() - 1][p.rank() - 1] = index;
-		m_pieces.insert({index, {p, p.owner(), p.file(), p.rank(), p.hasMoved(), p.type()}});
-	}
+	pFrom->file = move.from.x;
+	pFrom->rank = move.from.y;
+	pFrom->hasMoved = state.hasMoved;
 
-	if(!moves.empty())
+	if(state.capturedID != 0)
 	{
-		m_LastMove = {{moves[0].fromFile(), moves[0].fromRank()}, {moves[0].toFile(), moves[0].toRank()}};
+		const BoardPiece* pCaptured = GetPiece(state.capturedID);
+		assert(pCaptured != nullptr);
 
-		// todo: this copy could be avoided
-		if(moves.size() >= 8)
-		{
-			m_moveHistory.clear();
+		m_board[state.capturedPos.x - 1][state.capturedPos.y - 1] = state.capturedID;
 
-			for(unsigned int i = 0; i < 8; ++i)
-			{
-				m_moveHistory.push_back({{moves[i].fromFile(), moves[i].fromRank()}, {moves[i].toFile(), moves[i].toRank()}});
-			}
+		m_piecesCount[pCaptured->owner]++;
+		UpdateMinorPieceCounters(pCaptured->owner, pCaptured->type, 1);
+
+		if(pCaptured->type == 'Q')
+		{
+			m_hasQueen[pCaptured->owner] = true;
 		}
 	}
 
-	m_turnsToStalemate = turnsToStalemate;
-}
+	m_enPassantPos = state.enPassantPos;
+	m_turnsToStalemate = state.turnsToStalemate;
+	m_hash = state.hash;
 
-std::vector<BoardMove> Board::GetMoves(int playerID)
-{
-	return GetMoves(playerID, true);
+	m_hashHistory.pop_back();
+	m_stateStack.pop_back();
 }
 
 int Board::GetWorth(int playerID, const std::function<int(const Board& board, const BoardPiece&)>& heuristic)
@@ -401,7 +512,7 @@ bool Board::IsTileOwner(const ivec2& pos, int playerID) const
 
 bool Board::IsInCheckmate(int playerID)
 {
-	return IsInCheck(playerID) && GetMoves(playerID).empty();
+	return IsInCheck(playerID) && !HasAnyLegalMove(playerID);
 }
 
 bool Board::IsInStalemate(int playerID)
@@ -409,6 +520,111 @@ bool Board::IsInStalemate(int playerID)
 	return (m_turnsToStalemate == 0) || IsThreeBoardStateStalemate() || IsNotEnoughPiecesStalemate() || IsNoLegalMovesStalemate(playerID);
 }
 
+bool Board::HasAnyLegalMove(int playerID)
+{
+	std::vector<BoardMove> moves;
+	moves.reserve(28);
+
+	// Castling is skipped, it can only be valid if the king can also move one tile towards the rook
+	const BoardPiece* pKing = GetPiece(m_kingPos[playerID]);
+	assert(pKing != nullptr);
+
+	GenerateDiscreteMoves(*pKing, false, moves);
+
+	for(const BoardMove& move : moves)
+	{
+		if(IsValidMove(move))
+			return true;
+	}
+
+	for(auto& iter : m_board)
+	{
+		for(auto& subIter : iter)
+		{
+			auto pieceIter = m_pieces.find(subIter);
+			if(pieceIter != m_pieces.end())
+			{
+				const BoardPiece& piece = pieceIter->second;
+				if((piece.owner == playerID) && (piece.type != 'K'))
+				{
+					moves.clear();
+					GeneratePieceMoves(piece, false, moves);
+
+					for(const BoardMove& move : moves)
+					{
+						if(IsValidMove(move))
+							return true;
+					}
+				}
+			}
+		}
+	}
+
+	return false;
+}
+
+unsigned int Board::CountLegalMoves(int playerID)
+{
+	unsigned int count = 0;
+
+	std::vector<BoardMove> moves;
+	moves.reserve(28);
+
+	for(auto& iter : m_board)
+	{
+		for(auto& subIter : iter)
+		{
+			auto pieceIter = m_pieces.find(subIter);
+			if(pieceIter != m_pieces.end())
+			{
+				const BoardPiece& piece = pieceIter->second;
+				if(piece.owner == playerID)
+				{
+					moves.clear();
+
+					if(piece.type == 'K')
+					{
+						// Castle moves are only generated when they are valid
+						GenerateCastleMove(piece, true, moves);
+						count += moves.size();
+						moves.clear();
+					}
+
+					GeneratePieceMoves(piece, false, moves);
+
+					for(const BoardMove& move : moves)
+					{
+						if(IsValidMove(move))
+						{
+							++count;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	return count;
+}
+
+PositionStatus Board::GetPositionStatus(int playerID, std::vector<BoardMove>& movesOut, bool& bInCheckOut)
+{
+	movesOut = GetMoves(playerID, true);
+	bInCheckOut = IsInCheck(playerID);
+
+	if(movesOut.empty())
+	{
+		return bInCheckOut ? PositionStatus::Checkmate : PositionStatus::Stalemate;
+	}
+
+	if((m_turnsToStalemate == 0) || IsThreeBoardStateStalemate() || IsNotEnoughPiecesStalemate())
+	{
+		return PositionStatus::Stalemate;
+	}
+
+	return PositionStatus::Playing;
+}
+
 unsigned int Board::GetNumPieces() const
 {
 	return (m_piecesCount[0] + m_piecesCount[1]);
@@ -433,6 +649,59 @@ bool Board::IsEndGame() const
 	return true;	
 }
 
+int Board::SEE(const BoardMove& move) const
+{
+	const BoardPiece* pFrom = GetPiece(move.from);
+	assert(pFrom != nullptr);
+
+	// Swap list of the material gained after each capture on the destination tile
+	int gain[32];
+	int d = 0;
+
+	std::uint64_t removed = GetTileMask(move.from);
+	int attackerValue = GetExchangeValue(pFrom->type);
+
+	gain[0] = GetExchangeValue(move.capturedType);
+
+	if(move.specialMove == SpecialMove::EnPassant)
+	{
+		// The captured pawn is not on the destination tile
+		removed |= GetTileMask({move.to.x, move.from.y});
+	}
+	else if(move.specialMove == SpecialMove::Promotion)
+	{
+		gain[0] += GetExchangeValue(move.promotion) - GetExchangeValue('P');
+		attackerValue = GetExchangeValue(move.promotion);
+	}
+
+	int playerID = !pFrom->owner;
+	ivec2 attacker;
+
+	do
+	{
+		++d;
+
+		// Speculative gain if the piece that just captured gets captured
+		gain[d] = attackerValue - gain[d - 1];
+
+		if(!GetLeastValuableAttacker(move.to, playerID, removed, attacker))
+			break;
+
+		removed |= GetTileMask(attacker);
+		attackerValue = GetExchangeValue(GetPieceType(attacker));
+		playerID = !playerID;
+
+	} while(d < 31);
+
+	// Negamax the swap list back to the first capture
+	while(--d)
+	{
+		gain[d - 1] = -std::max(-gain[d - 1], gain[d]);
+	}
+
+	return gain[0];
+}
+
 std::vector<BoardMove> Board::GetMoves(int playerID, bool bCheck)
 {
 	std::vector<BoardMove> moves;
@@ -447,24 +716,7 @@ std::vector<BoardMove> Board::GetMoves(int playerID, bool bCheck)
 				const BoardPiece& piece = iter->second;
 				if(playerID == piece.owner)
 				{
-					switch(piece.type)
-					{
-					case 'P':
-						GeneratePawnMoves(piece, bCheck, moves);
-						break;
-					case 'K':
-						GenerateCastleMove(piece, bCheck, moves);
-					case 'N':
-						GenerateDiscreteMoves(piece, bCheck, moves);
-						break;
-					case 'B':
-					case 'R':
-					case 'Q':
-						GenerateDirectionMoves(piece, bCheck, moves);
-						break;
-					default:
-						assert("Invalid piece type" && false);
-					}
+					GeneratePieceMoves(piece, bCheck, moves);
 				}
 			}
 		}
@@ -473,6 +725,28 @@ std::vector<BoardMove> Board::GetMoves(int playerID, bool bCheck)
 	return moves;
 }
 
+void Board::GeneratePieceMoves(const BoardPiece& piece, bool bCheck, std::vector<BoardMove>& moves)
+{
+	switch(piece.type)
+	{
+	case 'P':
+		GeneratePawnMoves(piece, bCheck, moves);
+		break;
+	case 'K':
+		GenerateCastleMove(piece, bCheck, moves);
+	case 'N':
+		GenerateDiscreteMoves(piece, bCheck, moves);
+		break;
+	case 'B':
+	case 'R':
+	case 'Q':
+		GenerateDirectionMoves(piece, bCheck, moves);
+		break;
+	default:
+		assert("Invalid piece type" && false);
+	}
+}
+
 void Board::GeneratePawnMoves(const BoardPiece& piece, bool bCheck, std::vector<BoardMove>& moves)
 {
 	assert(piece.type == int('P'));
@@ -502,27 +776,15 @@ void Board::GeneratePawnMoves(const BoardPiece& piece, bool bCheck, std::vector<
 		}
 
 		// En passant check
-		if((piece.rank == 5 && piece.owner == 0) || (piece.rank == 4 && piece.owner == 1))
+		if((m_enPassantPos.y == piece.rank) && !IsTileOwner(m_enPassantPos, piece.owner))
 		{
-			if(abs(m_LastMove.to.y - m_LastMove.from.y) == 2)
-			{
-				BoardPiece* pLastPieceMoved = GetPiece(m_LastMove.to);
-				assert(pLastPieceMoved != nullptr);
-
-				if(pLastPieceMoved->type == int('P'))
-				{
-					if(pLastPieceMoved->rank == piece.rank)
-					{
-						int fileDiff = piece.file - pLastPieceMoved->file;
+			int fileDiff = piece.file - m_enPassantPos.x;
 
-						if(abs(fileDiff) == 1)
-						{
-							ivec2 from = {piece.file, piece.rank};
-							ivec2 to = {piece.file - fileDiff, iNewRank};
-							AddMove({from, to, 'P', 'Q', SpecialMove::EnPassant}, bCheck, moves);
-						}
-					}
-				}
+			if(abs(fileDiff) == 1)
+			{
+				ivec2 from = {piece.file, piece.rank};
+				ivec2 to = {piece.file - fileDiff, iNewRank};
+				AddMove({from, to, 'P', 'Q', SpecialMove::EnPassant}, bCheck, moves);
 			}
 		}
 
@@ -730,11 +992,7 @@ bool Board::AddMove(const BoardMove& move, bool bCheck, std::vector<BoardMove>&
 
 	if(bCheck)
 	{
-		BoardPiece* pFrom = GetPiece(move.from);
-		assert(pFrom != nullptr);
-
-		ApplyMove triedMove(move, this);
-		if((bValidMove = !IsInCheck(pFrom->owner)))
+		if((bValidMove = IsValidMove(move)))
 		{
 			moves.push_back(move);
 		}
@@ -747,23 +1005,210 @@ bool Board::AddMove(const BoardMove& move, bool bCheck, std::vector<BoardMove>&
 	return bValidMove;
 }
 
+bool Board::IsValidMove(const BoardMove& move)
+{
+	const BoardPiece* pFrom = GetPiece(move.from);
+	assert(pFrom != nullptr);
+
+	int owner = pFrom->owner;
+
+	MakeMove(move);
+	bool bValidMove = !IsInCheck(owner);
+	UnmakeMove(move);
+
+	return bValidMove;
+}
+
+void Board::MoveCastleRook(const BoardMove& move, bool bApply)
+{
+	int rookFile = 1;
+	int rookToFile = 4;
+
+	if((move.to.x - move.from.x) > 0)
+	{
+		// Rook will move to the left
+		rookFile = 8;
+		rookToFile = 6;
+	}
+
+	if(!bApply)
+	{
+		std::swap(rookFile, rookToFile);
+	}
+
+	BoardPiece* pRook = GetPiece({rookFile, move.from.y});
+	assert(pRook != nullptr);
+
+	if(bApply)
+	{
+		m_hash ^= GetPieceKey(pRook->owner, pRook->type, {rookFile, move.from.y});
+		m_hash ^= GetPieceKey(pRook->owner, pRook->type, {rookToFile, move.from.y});
+	}
+
+	pRook->file = rookToFile;
+	pRook->hasMoved = bApply;
+
+	std::swap(m_board[rookFile - 1][move.from.y - 1], m_board[rookToFile - 1][move.from.y - 1]);
+}
+
+void Board::AddPiece(const BoardPiece& piece)
+{
+	// Count of pieces on the board
+	m_piecesCount[piece.owner]++;
+
+	// Cache locations of bishops and kings and count the number of knights and bishops
+	switch(piece.type)
+	{
+		case 'N':
+			m_knightCounter[piece.owner]++;
+			break;
+		case 'B':
+			m_bishopCounter[piece.owner]++;
+			m_bishopPos[piece.owner] = {piece.file, piece.rank};
+			break;
+		case 'Q':
+			m_hasQueen[piece.owner] = true;
+			break;
+		case 'K':
+			m_kingPos[piece.owner] = {piece.file, piece.rank};
+			break;
+		default:
+			break;
+	}
+
+	m_board[piece.file - 1][piece.rank - 1] = piece.id;
+	m_pieces.insert({piece.id, piece});
+}
+
+void Board::UpdateMinorPieceCounters(int owner, int type, int delta)
+{
+	if(type == 'N')
+	{
+		m_knightCounter[owner] += delta;
+	}
+	else if(type == 'B')
+	{
+		m_bishopCounter[owner] += delta;
+	}
+}
+
 bool Board::IsInCheck(int playerID)
 {
-	// Generate moves for the other team
-	std::vector<BoardMove> validMoves = GetMoves(!playerID, false);
+	// Check if any of their pieces are attacking our king, the search stops at the first attacker found
+	ivec2 attacker;
+	return GetLeastValuableAttacker(m_kingPos[playerID], !playerID, 0, attacker);
+}
 
-	// Check if any of their pieces are attacking our king
-	auto iter = std::find_if(validMoves.begin(),validMoves.end(),[&](const BoardMove& m) -> bool
+bool Board::GetLeastValuableAttacker(const ivec2& pos, int playerID, std::uint64_t removed, ivec2& attackerOut) const
+{
+	auto IsAttacker = [&](const ivec2& tile, int type) -> bool
 	{
-		return (m.to == m_kingPos[playerID]);
-	});
+		if(!IsTileOccupied(tile, removed))
+			return false;
+
+		const BoardPiece* pPiece = GetPiece(tile);
+		return (pPiece->owner == playerID) && (pPiece->type == type);
+	};
 
-	return iter != validMoves.end();
+	// Pawns attack diagonally forward, so look diagonally backward from pos
+	int iPawnRank = pos.y - ((playerID == 0) ? 1 : -1);
+	for(int iFile : {pos.x - 1, pos.x + 1})
+	{
+		if(IsAttacker({iFile, iPawnRank}, 'P'))
+		{
+			attackerOut = {iFile, iPawnRank};
+			return true;
+		}
+	}
+
+	const ivec2 knightDir[] =
+	{
+		{1, 2}, {2, 1}, {-2, 1}, {-1, 2},
+		{1, -2}, {2, -1}, {-2, -1}, {-1, -2}
+	};
+
+	for(const ivec2& dir : knightDir)
+	{
+		ivec2 tile = {pos.x + dir.x, pos.y + dir.y};
+		if(IsAttacker(tile, 'N'))
+		{
+			attackerOut = tile;
+			return true;
+		}
+	}
+
+	const ivec2 slideDir[] =
+	{
+		// Bishop
+		{1,1},
+		{-1,1},
+		{1,-1},
+		{-1,-1},
+
+		// Rook
+		{1,0},
+		{-1,0},
+		{0,1},
+		{0,-1}
+	};
+
+	// Walk each ray to the first piece that has not been removed from the exchange
+	int bestValue = 0;
+	for(unsigned int i = 0; i < 8; ++i)
+	{
+		ivec2 tile = pos;
+
+		do
+		{
+			tile.x += slideDir[i].x;
+			tile.y += slideDir[i].y;
+
+		} while(IsOnBoard(tile) && !IsTileOccupied(tile, removed));
+
+		if(IsOnBoard(tile))
+		{
+			const BoardPiece* pPiece = GetPiece(tile);
+			int sliderType = (i < 4) ? 'B' : 'R';
+
+			if((pPiece->owner == playerID) && ((pPiece->type == sliderType) || (pPiece->type == 'Q')))
+			{
+				int value = GetExchangeValue(pPiece->type);
+				if((bestValue == 0) || (value < bestValue))
+				{
+					bestValue = value;
+					attackerOut = tile;
+				}
+			}
+		}
+	}
+
+	if(bestValue != 0)
+		return true;
+
+	for(const ivec2& dir : slideDir)
+	{
+		ivec2 tile = {pos.x + dir.x, pos.y + dir.y};
+		if(IsAttacker(tile, 'K'))
+		{
+			attackerOut = tile;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool Board::IsTileOccupied(const ivec2& pos, std::uint64_t removed) const
+{
+	if(!IsOnBoard(pos) || IsTileEmpty(pos))
+		return false;
+
+	return (removed & GetTileMask(pos)) == 0;
 }
 
 bool Board::IsNoLegalMovesStalemate(int playerID)
 {
-	return GetMoves(playerID).empty() && !IsInCheck(playerID);
+	return !HasAnyLegalMove(playerID) && !IsInCheck(playerID);
 }
 
 bool Board::IsNotEnoughPiecesStalemate() const
@@ -809,22 +1254,199 @@ bool Board::IsNotEnoughPiecesStalemate() const
 
 bool Board::IsThreeBoardStateStalemate() const
 {
-	// todo: this could be optimized
+	// Only positions since the last capture or pawn move can be repeated
+	int current = int(m_hashHistory.size()) - 1;
+	int reversiblePlies = std::min(100 - m_turnsToStalemate, current);
+	int repetitions = 0;
 
-	// Test 3: three board state repetition draw rule
-	if(m_turnsToStalemate <= 92 && m_moveHistory.size() >= 8)
+	// The same player must be moving for the position to repeat, so only every other position is checked
+	for(int i = 4; i <= reversiblePlies; i += 2)
 	{
-		auto equalFunctor = [](const BoardMove& a, const BoardMove& b) -> bool
+		int index = current - i;
+		if(m_hashHistory[index] == m_hash)
 		{
-			return (a.from == b.from && a.to == b.to);
-		};
-
-		return std::equal(m_moveHistory.begin(), m_moveHistory.begin() + 4, m_moveHistory.begin() + 4, equalFunctor);
+			if((index > m_rootHashIndex) || (++repetitions == 2))
+				return true;
+		}
 	}
 
 	return false;
 }
 
+void Board::UpdateHashHistory(const std::vector<BoardMove>& moves)
+{
+	// The player who made the last move owns the piece on its destination tile
+	int playerIDToMove = 0;
+	if(!moves.empty())
+	{
+		const BoardPiece* pLastMoved = GetPiece(moves[0].to);
+		if(pLastMoved != nullptr)
+		{
+			playerIDToMove = !pLastMoved->owner;
+		}
+	}
+
+	m_hash = ComputeHash(playerIDToMove);
+
+	// Walk the reversible moves backwards, they can be undone without knowing what was captured
+	std::vector<std::uint64_t> previousHashes;
+	std::vector<std::vector<int>> board = m_board;
+	std::uint64_t hash = m_hash;
+
+	// Kings and rooks which have moved in the current position, but had not before one of the undone moves
+	std::vector<int> unmovedIDs;
+	std::uint64_t castlingKey = GetCastlingKey(0, board, unmovedIDs) ^ GetCastlingKey(1, board, unmovedIDs);
+
+	int reversiblePlies = std::min(100 - m_turnsToStalemate, int(moves.size()));
+	int undonePlies = 0;
+	for(int i = 0; i < reversiblePlies; ++i)
+	{
+		const ivec2& from = moves[i].from;
+		const ivec2& to = moves[i].to;
+
+		if(!IsOnBoard(from) || !IsOnBoard(to) || (board[from.x - 1][from.y - 1] != 0))
+			break;
+
+		const BoardPiece* pPiece = GetPiece(board[to.x - 1][to.y - 1]);
+		if(pPiece == nullptr)
+			break;
+
+		std::swap(board[from.x - 1][from.y - 1], board[to.x - 1][to.y - 1]);
+		hash ^= GetPieceKey(pPiece->owner, pPiece->type, from) ^ GetPieceKey(pPiece->owner, pPiece->type, to) ^ s_zobristKeys.blackToMove;
+
+		// A king or rook leaving a tile which no earlier move of the game touched was making its first move
+		bool bFirstMove = (pPiece->type == 'K') || (pPiece->type == 'R');
+		for(unsigned int j = i + 1; bFirstMove && (j < moves.size()); ++j)
+		{
+			bFirstMove = (moves[j].from != from) && (moves[j].to != from);
+		}
+
+		if(bFirstMove)
+		{
+			unmovedIDs.push_back(pPiece->id);
+		}
+
+		// Put the rook back into the corner when undoing a castle
+		if((pPiece->type == 'K') && (abs(to.x - from.x) == 2))
+		{
+			int rookFile = (to.x > from.x) ? 8 : 1;
+			int rookToFile = (to.x > from.x) ? 6 : 4;
+
+			const BoardPiece* pRook = GetPiece(board[rookToFile - 1][from.y - 1]);
+			if(pRook == nullptr)
+				break;
+
+			std::swap(board[rookFile - 1][from.y - 1], board[rookToFile - 1][from.y - 1]);
+			hash ^= GetPieceKey(pRook->owner, pRook->type, {rookFile, from.y}) ^ GetPieceKey(pRook->owner, pRook->type, {rookToFile, from.y});
+			unmovedIDs.push_back(pRook->id);
+		}
+
+		if(bFirstMove)
+		{
+			std::uint64_t previousCastlingKey = GetCastlingKey(0, board, unmovedIDs) ^ GetCastlingKey(1, board, unmovedIDs);
+			hash ^= castlingKey ^ previousCastlingKey;
+			castlingKey = previousCastlingKey;
+		}
+
+		previousHashes.push_back(hash);
+		++undonePlies;
+	}
+
+	// The oldest position follows the last irreversible move, which leaves a pawn to capture en passant if it was a double push
+	if((undonePlies > 0) && (undonePlies == reversiblePlies) && (reversiblePlies < int(moves.size())))
+	{
+		const BoardMove& irreversibleMove = moves[reversiblePlies];
+		const BoardPiece* pPawn = GetPiece(board[irreversibleMove.to.x - 1][irreversibleMove.to.y - 1]);
+		if((pPawn != nullptr) && (pPawn->type == 'P') && (abs(irreversibleMove.to.y - irreversibleMove.from.y) == 2))
+		{
+			previousHashes.back() ^= GetEnPassantKey(irreversibleMove.to, board);
+		}
+	}
+
+	m_hashHistory.clear();
+	m_hashHistory.reserve(previousHashes.size() + 256);
+	m_hashHistory.assign(previousHashes.rbegin(), previousHashes.rend());
+	m_hashHistory.push_back(m_hash);
+
+	m_rootHashIndex = int(m_hashHistory.size()) - 1;
+}
+
+std::uint64_t Board::ComputeHash(int playerIDToMove) const
+{
+	std::uint64_t hash = (playerIDToMove == 1) ? s_zobristKeys.blackToMove : 0;
+
+	// Captured pieces stay in the list of pieces, so only the pieces on the board are hashed
+	for(const auto& iter : m_board)
+	{
+		for(int id : iter)
+		{
+			const BoardPiece* pPiece = GetPiece(id);
+			if(pPiece != nullptr)
+			{
+				hash ^= GetPieceKey(pPiece->owner, pPiece->type, {pPiece->file, pPiece->rank});
+			}
+		}
+	}
+
+	hash ^= GetCastlingKey(0, m_board, std::vector<int>()) ^ GetCastlingKey(1, m_board, std::vector<int>());
+	hash ^= GetEnPassantKey(m_enPassantPos, m_board);
+
+	return hash;
+}
+
+std::uint64_t Board::GetCastlingKey(int owner, const std::vector<std::vector<int>>& board, const std::vector<int>& unmovedIDs) const
+{
+	int homeRank = (owner == 0) ? 1 : 8;
+
+	// Returns true if the tile holds a king or rook of the owner which has not moved
+	auto isUnmoved = [&](int file, int pieceType) -> bool
+	{
+		const BoardPiece* pPiece = GetPiece(board[file - 1][homeRank - 1]);
+		return (pPiece != nullptr) && (pPiece->owner == owner) && (pPiece->type == pieceType) &&
+			   (!pPiece->hasMoved || (std::find(unmovedIDs.begin(), unmovedIDs.end(), pPiece->id) != unmovedIDs.end()));
+	};
+
+	if(!isUnmoved(5, 'K'))
+		return 0;
+
+	std::uint64_t key = 0;
+	if(isUnmoved(1, 'R'))
+	{
+		key ^= s_zobristKeys.castling[owner][0];
+	}
+
+	if(isUnmoved(8, 'R'))
+	{
+		key ^= s_zobristKeys.castling[owner][1];
+	}
+
+	return key;
+}
+
+std::uint64_t Board::GetEnPassantKey(const ivec2& pawnPos, const std::vector<std::vector<int>>& board) const
+{
+	if(!IsOnBoard(pawnPos))
+		return 0;
+
+	const BoardPiece* pPawn = GetPiece(board[pawnPos.x - 1][pawnPos.y - 1]);
+	if(pPawn == nullptr)
+		return 0;
+
+	// The right only changes the position when a pawn of the opponent stands beside the pawn to capture it
+	for(int fileOffset : {-1, 1})
+	{
+		ivec2 pos = {pawnPos.x + fileOffset, pawnPos.y};
+		if(IsOnBoard(pos))
+		{
+			const BoardPiece* pPiece = GetPiece(board[pos.x - 1][pos.y - 1]);
+			if((pPiece != nullptr) && (pPiece->type == 'P') && (pPiece->owner != pPawn->owner))
+				return s_zobristKeys.enPassantFile[pawnPos.x - 1];
+		}
+	}
+
+	return 0;
+}
+
 void Board::Clear()
 {
 	m_piecesCount[0] = m_piecesCount[1] = 0;
@@ -832,6 +1454,8 @@ void Board::Clear()
 	m_bishopCounter[0] = m_bishopCounter[1] = 0;
 	m_bishopPos[0] = m_bishopPos[1] = ivec2();
 	m_hasQueen[0] = m_hasQueen[1] = false;
+	m_enPassantPos = ivec2();
+	m_stateStack.clear();
 
 	// Clear the board of pieces
 	for(auto& fileIter : m_board)
@@ -1,18 +1,18 @@
 #ifndef _BOARD_
 #define _BOARD_
 
-#include "Piece.h"
-#include "Move.h"
 #include "vec2.h"
 #include "BoardMove.h"
 #include <unordered_map>
-#include <deque>
 #include <functional>
+#include <string>
 #include <vector>
+#include <cstdint>
 
 struct BoardPiece
 {
-	Piece piece;
+	// Identifier of the piece, unique among the pieces of the board
+	int id;
 	int owner;
 	int file;
 	int rank;
@@ -22,6 +22,14 @@ struct BoardPiece
 
 bool operator ==(const BoardPiece& a, const BoardPiece& b);
 
+// Describes whether the game can continue from a position
+enum class PositionStatus
+{
+	Playing,
+	Checkmate,
+	Stalemate
+};
+
 // Moves, then unmoves a piece move upon destruction
 class ApplyMove
 {
@@ -30,51 +38,21 @@ public:
 	ApplyMove(const BoardMove& move, class Board* pBoard);
 	~ApplyMove();
 
-private:
-
-	void ApplyCastleMove(bool bApply);
-
 private:
 
 	BoardMove m_move;
 	Board* m_pBoard;
-
-	int m_newIndex;
-	int m_hasMoved;
-	int m_oldTurnsToStalemate;
-	int m_type;
-	BoardMove m_LastMove;
-	ivec2 m_oldKingPos;
-};
-
-class Board;
-
-class BoardHash
-{
-public:
-	
-	static void SetBoard(const Board* pBoard);
-
-	std::size_t operator()(const std::vector<std::vector<int>>& key) const;
-	
-private:
-	
-	static const Board* s_pBoard;
-
 };
 
-class BoardEqual
+// Saves the parts of the board which cannot be recovered from a move when undoing it
+struct StateInfo
 {
-public:
-	
-	static void SetBoard(const Board* pBoard);
-	
-	bool operator()(const std::vector<std::vector<int>>& a, const std::vector<std::vector<int>>& b) const;
-	
-private:
-	
-	static const Board* s_pBoard;
-	
+	int capturedID;
+	ivec2 capturedPos;
+	int hasMoved;
+	ivec2 enPassantPos;
+	int turnsToStalemate;
+	std::uint64_t hash;
 };
 
 // Defines a chess board which manages generating valid action states
@@ -82,17 +60,29 @@ class Board
 {
 public:
 
-	friend class ApplyMove;
-
 	// Constructs an empty board
 	Board();
 
-	// Updates the grid
-	void Update(int turnsToStalemate, const std::vector<Move>& moves, const std::vector<Piece>& pieces);
+	// Updates the grid with the pieces on the board and the moves played in the game, the last move first
+	void Update(int turnsToStalemate, const std::vector<BoardMove>& moves, const std::vector<BoardPiece>& pieces);
+
+	// Sets up the position described by a FEN string, the move counters are optional.
+	// playerIDToMoveOut is set to the player to move, returns false if the string does not describe a position with one king for each player
+	bool LoadFEN(const std::string& fen, int& playerIDToMoveOut);
+
+	// Makes the current position the root of the next search, so that the moves made before it count as moves of the game.
+	// A position of the game is only a draw once it is repeated three times, while one inside the search is a draw when repeated once
+	void SetRoot() { m_rootHashIndex = int(m_hashHistory.size()) - 1; }
 
 	// Returns all valid moves for the specified player
 	std::vector<BoardMove> GetMoves(int playerID);
 
+	// Applies the move to the board, saving the state needed to undo it
+	void MakeMove(const BoardMove& move);
+
+	// Undoes the last move applied with MakeMove
+	void UnmakeMove(const BoardMove& move);
+
 	// Returns the value of the game state for the player
 	int GetWorth(int playerID, const std::function<int(const Board&, const BoardPiece&)>& heuristic);
 
@@ -107,6 +97,12 @@ public:
 	// Returns the state of the board
 	const std::vector<std::vector<int>>& GetState() const { return m_board; }
 
+	// Returns the number of moves left before the game is a draw by the fifty move rule
+	int GetTurnsToStalemate() const { return m_turnsToStalemate; }
+
+	// Returns the Zobrist key of the current position
+	std::uint64_t GetHash() const { return m_hash; }
+
 	// Returns true if pos is on the board
 	bool IsOnBoard(int pos) const;
 
@@ -119,12 +115,30 @@ public:
 	// Returns true if we currently own the tile
 	bool IsTileOwner(const ivec2& pos, int playerID) const;
 
+	// Returns true if playerID is in check
+	bool IsInCheck(int playerID);
+
 	// Returns true if the specified player is in checkmate
 	bool IsInCheckmate(int playerID);
 
 	// Returns true if the specified player is in stalemate
 	bool IsInStalemate(int playerID);
 
+	// Returns true as soon as a single valid move is found for the specified player.
+	// King moves are tried first as they are the most likely to be valid when the player is in check
+	bool HasAnyLegalMove(int playerID);
+
+	// Returns the number of valid moves for the specified player without building the full move list
+	unsigned int CountLegalMoves(int playerID);
+
+	// Classifies the position for the specified player to move while generating their legal moves only once.
+	// movesOut is filled with every valid move and bInCheckOut is set to whether the player is in check
+	PositionStatus GetPositionStatus(int playerID, std::vector<BoardMove>& movesOut, bool& bInCheckOut);
+
+	// Returns the static exchange evaluation of the move from the perspective of the player making it.
+	// A negative value means that the move loses material if both players keep capturing on the destination tile
+	int SEE(const BoardMove& move) const;
+
 	// Returns the number of pieces on the board
 	unsigned int GetNumPieces() const;
 	
@@ -132,11 +146,17 @@ public:
 
 private:
 
+	// Places the piece on the board and updates the piece counters
+	void AddPiece(const BoardPiece& piece);
+
 	// Returns all moves for the specified player
 	// If bCheck is true, all moves will be valid moves.
 	// If bCheck is false, returns all pseudo legal moves. Checking if the king is put in check after the move is not done.
 	std::vector<BoardMove> GetMoves(int playerID, bool bCheck);
 
+	// Generates moves for a single piece based on its type
+	void GeneratePieceMoves(const BoardPiece& piece, bool bCheck, std::vector<BoardMove>& moves);
+
 	// Generate valid moves for pawns
 	void GeneratePawnMoves(const BoardPiece& piece, bool bCheck, std::vector<BoardMove>& moves);
 
@@ -160,8 +180,22 @@ private:
 	// Returns true if move is valid or bCheck is false, false otherwise
 	bool AddMove(const BoardMove& move, bool bCheck, std::vector<BoardMove>& moves);
 
-	// Returns true if playerID is in check
-	bool IsInCheck(int playerID);
+	// Returns true if the move does not leave the king of the player making it in check
+	bool IsValidMove(const BoardMove& move);
+
+	// Moves the rook next to the king for a castle move, or back to its corner if bApply is false
+	void MoveCastleRook(const BoardMove& move, bool bApply);
+
+	// Adds delta to the number of knights or bishops of the owner
+	void UpdateMinorPieceCounters(int owner, int type, int delta);
+
+	// Finds the least valuable piece owned by playerID which attacks pos, ignoring every tile marked in the removed mask.
+	// Sliding pieces behind removed tiles are found, so x-ray attackers join the exchange once the piece in front of them is gone.
+	// Returns false if there is no attacker
+	bool GetLeastValuableAttacker(const ivec2& pos, int playerID, std::uint64_t removed, ivec2& attackerOut) const;
+
+	// Returns true if the tile contains a piece which has not been marked in the removed mask
+	bool IsTileOccupied(const ivec2& pos, std::uint64_t removed) const;
 
 	// Returns true if there are no legal moves for the specified player
 	bool IsNoLegalMovesStalemate(int playerID);
@@ -169,9 +203,22 @@ private:
 	// Returns true if there is not enough pieces on the board
 	bool IsNotEnoughPiecesStalemate() const;
 
-	// Returns true if there is a three board repatition stalemate condition
+	// Returns true if there is a three board repatition stalemate condition.
+	// A position repeated once inside the search tree also counts, since the same moves can repeat it a third time
 	bool IsThreeBoardStateStalemate() const;
 
+	// Rebuilds the keys of the positions since the last capture or pawn move by undoing the reversible moves played in the game
+	void UpdateHashHistory(const std::vector<BoardMove>& moves);
+
+	// Returns the Zobrist key of every piece on the board, the castling and en passant rights and the player to move
+	std::uint64_t ComputeHash(int playerIDToMove) const;
+
+	// Returns the Zobrist keys of the castling rights of the owner on the grid, the pieces in unmovedIDs count as not moved
+	std::uint64_t GetCastlingKey(int owner, const std::vector<std::vector<int>>& board, const std::vector<int>& unmovedIDs) const;
+
+	// Returns the Zobrist key of the pawn at pawnPos being capturable en passant on the grid, 0 if no pawn of the opponent can capture it
+	std::uint64_t GetEnPassantKey(const ivec2& pawnPos, const std::vector<std::vector<int>>& board) const;
+
 	// Clears the board
 	void Clear();
 
@@ -180,10 +227,20 @@ private:
 	std::vector<std::vector<int>> m_board;
 	std::unordered_map<int,BoardPiece> m_pieces;
 
-	std::deque<BoardMove> m_moveHistory;
+	// Zobrist keys of every position since the start of the game history, the last entry is the current position
+	std::vector<std::uint64_t> m_hashHistory;
+	std::uint64_t m_hash;
+
+	// Index of the position received from the server in m_hashHistory
+	int m_rootHashIndex;
+
+	// Undo information for each move applied with MakeMove
+	std::vector<StateInfo> m_stateStack;
 
 	ivec2 m_kingPos[2];
-	BoardMove m_LastMove;
+
+	// Position of the pawn which can be captured en passant
+	ivec2 m_enPassantPos;
 	
 	int m_turnsToStalemate;
 	int m_piecesCount[2];
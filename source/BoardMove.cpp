@@ -8,6 +8,16 @@ static char NumberToLetter(int number)
 	return char((number - 1) + 'a');
 }
 
+bool operator==(const BoardMove& a, const BoardMove& b)
+{
+	return (a.from == b.from) && (a.to == b.to) && (a.promotion == b.promotion);
+}
+
+bool operator!=(const BoardMove& a, const BoardMove& b)
+{
+	return !(a == b);
+}
+
 std::ostream& operator<<(std::ostream& stream, const BoardMove& move)
 {
 	char spacing = '-';
@@ -39,6 +39,10 @@ struct BoardMove
 	SpecialMove specialMove;
 };
 
+// Returns true if both moves move the same piece to the same tile with the same promotion
+bool operator==(const BoardMove& a, const BoardMove& b);
+bool operator!=(const BoardMove& a, const BoardMove& b);
+
 std::ostream& operator<<(std::ostream& stream, const BoardMove& move);
 
 #endif // _BOARDMOVE_
@@ -0,0 +1,386 @@
+#include "Log.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+// Number of records in the buffer of each thread, must be a power of two
+static const std::uint64_t LOG_BUFFER_SIZE = 256;
+
+// Time in milliseconds the writer thread sleeps when all buffers are empty
+static const unsigned int LOG_WRITER_SLEEP = 1;
+
+// Ring of records with a single producer, the thread that owns it, and a single consumer, the writer thread
+struct LogBuffer
+{
+	LogBuffer() : records(new LogRecord[LOG_BUFFER_SIZE]), head(0), tail(0), dropped(0), bRetired(false)
+	{
+	}
+
+	std::unique_ptr<LogRecord[]> records;
+
+	// Index of the next record to write, only advanced by the owning thread
+	std::atomic<std::uint64_t> head;
+
+	// Index of the next record to read, only advanced by the writer thread
+	std::atomic<std::uint64_t> tail;
+
+	// Number of messages dropped because the buffer was full
+	std::atomic<std::uint64_t> dropped;
+
+	// Raised when the owning thread exits, the buffer is removed once it has been drained
+	std::atomic_bool bRetired;
+};
+
+// Formats and writes the messages of all threads on a background thread
+class LogWriter
+{
+public:
+
+	static LogWriter& Get();
+
+	~LogWriter();
+
+	void AddBuffer(const std::shared_ptr<LogBuffer>& pBuffer);
+	void SetStream(std::ostream* pStream);
+
+	// Writes all committed messages ordered by time, returns true if anything was written
+	bool Drain();
+
+private:
+
+	LogWriter();
+
+	void Run();
+
+private:
+
+	std::mutex m_buffersMutex;
+	std::vector<std::shared_ptr<LogBuffer>> m_buffers;
+
+	// Serializes draining between the writer thread and FlushLog, and guards the stream
+	std::mutex m_drainMutex;
+	std::ostream* m_pStream;
+	std::vector<LogRecord> m_batch;
+
+	std::atomic_bool m_bStop;
+	std::thread m_thread;
+};
+
+// Owns the buffer of a thread and retires it when the thread exits
+class LogBufferOwner
+{
+public:
+
+	LogBufferOwner() : m_pBuffer(std::make_shared<LogBuffer>())
+	{
+		LogWriter::Get().AddBuffer(m_pBuffer);
+	}
+
+	~LogBufferOwner()
+	{
+		m_pBuffer->bRetired = true;
+	}
+
+	LogBuffer& GetBuffer() { return *m_pBuffer; }
+
+private:
+
+	std::shared_ptr<LogBuffer> m_pBuffer;
+};
+
+static thread_local LogBufferOwner t_bufferOwner;
+
+static void FormatArgument(std::ostream& stream, const LogArgument& argument)
+{
+	switch(argument.type)
+	{
+	case LogArgument::Type::Int:
+		stream << argument.value.i;
+		break;
+	case LogArgument::Type::UInt:
+		stream << argument.value.u;
+		break;
+	case LogArgument::Type::Double:
+		stream << argument.value.d;
+		break;
+	case LogArgument::Type::Char:
+		stream << char(argument.value.i);
+		break;
+	case LogArgument::Type::Bool:
+		stream << (argument.value.i != 0 ? "true" : "false");
+		break;
+	case LogArgument::Type::Text:
+		stream << argument.text;
+		break;
+	case LogArgument::Type::Move:
+	{
+		std::uint64_t packed = argument.value.u;
+		BoardMove move({int(packed & 0xF), int((packed >> 4) & 0xF)}, {int((packed >> 8) & 0xF), int((packed >> 12) & 0xF)},
+					   int((packed >> 16) & 0xFF), int((packed >> 24) & 0xFF), static_cast<SpecialMove>(packed >> 32));
+
+		// The move is printed on its own line by operator<<, which is not wanted in the middle of a message
+		std::ostringstream moveStream;
+		moveStream << move;
+		std::string text = moveStream.str();
+		text.erase(std::remove(text.begin(), text.end(), '\n'), text.end());
+		stream << text;
+		break;
+	}
+	}
+}
+
+static void FormatRecord(std::ostream& stream, const LogRecord& record)
+{
+	if(record.level == LogLevel::Warning)
+	{
+		stream << "Warning: ";
+	}
+	else if(record.level == LogLevel::Error)
+	{
+		stream << "Error: ";
+	}
+
+	unsigned int argument = 0;
+	for(const char* pChar = record.format; *pChar != '\0'; ++pChar)
+	{
+		if((pChar[0] == '{') && (pChar[1] == '}') && (argument < record.argumentCount))
+		{
+			FormatArgument(stream, record.arguments[argument++]);
+			++pChar;
+		}
+		else
+		{
+			stream << *pChar;
+		}
+	}
+
+	stream << '\n';
+}
+
+LogWriter& LogWriter::Get()
+{
+	static LogWriter writer;
+	return writer;
+}
+
+LogWriter::LogWriter() : m_pStream(&std::cout), m_bStop(false), m_thread(&LogWriter::Run, this)
+{
+}
+
+LogWriter::~LogWriter()
+{
+	m_bStop = true;
+	m_thread.join();
+}
+
+void LogWriter::AddBuffer(const std::shared_ptr<LogBuffer>& pBuffer)
+{
+	m_buffersMutex.lock();
+	m_buffers.push_back(pBuffer);
+	m_buffersMutex.unlock();
+}
+
+void LogWriter::SetStream(std::ostream* pStream)
+{
+	m_drainMutex.lock();
+	m_pStream = pStream;
+	m_drainMutex.unlock();
+}
+
+bool LogWriter::Drain()
+{
+	m_drainMutex.lock();
+
+	m_buffersMutex.lock();
+	std::vector<std::shared_ptr<LogBuffer>> buffers = m_buffers;
+	m_buffersMutex.unlock();
+
+	m_batch.clear();
+	std::uint64_t dropped = 0;
+	bool bHasRetired = false;
+
+	for(auto& pBuffer : buffers)
+	{
+		// The flag is read before the head, so a retired buffer is empty after this pass
+		bool bRetired = pBuffer->bRetired;
+		std::uint64_t tail = pBuffer->tail.load(std::memory_order_relaxed);
+		std::uint64_t head = pBuffer->head.load(std::memory_order_acquire);
+
+		for(; tail != head; ++tail)
+		{
+			m_batch.push_back(pBuffer->records[tail & (LOG_BUFFER_SIZE - 1)]);
+		}
+
+		pBuffer->tail.store(tail, std::memory_order_release);
+		dropped += pBuffer->dropped.exchange(0, std::memory_order_relaxed);
+		bHasRetired = bHasRetired || bRetired;
+	}
+
+	if(bHasRetired)
+	{
+		m_buffersMutex.lock();
+		m_buffers.erase(std::remove_if(m_buffers.begin(), m_buffers.end(), [](const std::shared_ptr<LogBuffer>& pBuffer) -> bool
+		{
+			return pBuffer->bRetired && (pBuffer->tail.load(std::memory_order_relaxed) == pBuffer->head.load(std::memory_order_acquire));
+		}), m_buffers.end());
+		m_buffersMutex.unlock();
+	}
+
+	bool bWrite = !m_batch.empty() || (dropped > 0);
+	if(bWrite && (m_pStream != nullptr))
+	{
+		std::stable_sort(m_batch.begin(), m_batch.end(), [](const LogRecord& a, const LogRecord& b) -> bool
+		{
+			return a.time < b.time;
+		});
+
+		std::ostringstream text;
+		for(const LogRecord& record : m_batch)
+		{
+			FormatRecord(text, record);
+		}
+
+		if(dropped > 0)
+		{
+			text << "Warning: " << dropped << " log messages were dropped\n";
+		}
+
+		*m_pStream << text.str() << std::flush;
+	}
+
+	m_drainMutex.unlock();
+
+	return bWrite;
+}
+
+void LogWriter::Run()
+{
+	while(!m_bStop)
+	{
+		if(!Drain())
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(LOG_WRITER_SLEEP));
+		}
+	}
+
+	Drain();
+}
+
+LogRecord* BeginLogRecord(LogLevel level, const char* format)
+{
+	LogBuffer& buffer = t_bufferOwner.GetBuffer();
+	std::uint64_t head = buffer.head.load(std::memory_order_relaxed);
+
+	// Never wait on the writer, a message that does not fit is dropped and counted
+	if((head - buffer.tail.load(std::memory_order_acquire)) >= LOG_BUFFER_SIZE)
+	{
+		buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	LogRecord& record = buffer.records[head & (LOG_BUFFER_SIZE - 1)];
+	record.level = level;
+	record.format = format;
+	record.time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	record.argumentCount = 0;
+
+	return &record;
+}
+
+void CommitLogRecord()
+{
+	LogBuffer& buffer = t_bufferOwner.GetBuffer();
+	buffer.head.store(buffer.head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void FlushLog()
+{
+	LogWriter::Get().Drain();
+}
+
+void SetLogStream(std::ostream* pStream)
+{
+	LogWriter::Get().SetStream(pStream);
+}
+
+void SetLogArgument(LogArgument& argument, int value)
+{
+	argument.type = LogArgument::Type::Int;
+	argument.value.i = value;
+}
+
+void SetLogArgument(LogArgument& argument, unsigned int value)
+{
+	argument.type = LogArgument::Type::UInt;
+	argument.value.u = value;
+}
+
+void SetLogArgument(LogArgument& argument, long value)
+{
+	argument.type = LogArgument::Type::Int;
+	argument.value.i = value;
+}
+
+void SetLogArgument(LogArgument& argument, unsigned long value)
+{
+	argument.type = LogArgument::Type::UInt;
+	argument.value.u = value;
+}
+
+void SetLogArgument(LogArgument& argument, long long value)
+{
+	argument.type = LogArgument::Type::Int;
+	argument.value.i = value;
+}
+
+void SetLogArgument(LogArgument& argument, unsigned long long value)
+{
+	argument.type = LogArgument::Type::UInt;
+	argument.value.u = value;
+}
+
+void SetLogArgument(LogArgument& argument, double value)
+{
+	argument.type = LogArgument::Type::Double;
+	argument.value.d = value;
+}
+
+void SetLogArgument(LogArgument& argument, char value)
+{
+	argument.type = LogArgument::Type::Char;
+	argument.value.i = value;
+}
+
+void SetLogArgument(LogArgument& argument, bool value)
+{
+	argument.type = LogArgument::Type::Bool;
+	argument.value.i = value;
+}
+
+void SetLogArgument(LogArgument& argument, const char* value)
+{
+	argument.type = LogArgument::Type::Text;
+	std::strncpy(argument.text, value, MAX_LOG_TEXT - 1);
+	argument.text[MAX_LOG_TEXT - 1] = '\0';
+}
+
+void SetLogArgument(LogArgument& argument, const std::string& value)
+{
+	SetLogArgument(argument, value.c_str());
+}
+
+void SetLogArgument(LogArgument& argument, const BoardMove& value)
+{
+	argument.type = LogArgument::Type::Move;
+	argument.value.u = std::uint64_t(value.from.x & 0xF) | (std::uint64_t(value.from.y & 0xF) << 4) |
+		(std::uint64_t(value.to.x & 0xF) << 8) | (std::uint64_t(value.to.y & 0xF) << 12) |
+		(std::uint64_t(value.capturedType & 0xFF) << 16) | (std::uint64_t(value.promotion & 0xFF) << 24) |
+		(std::uint64_t(value.specialMove) << 32);
+}
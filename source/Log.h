@@ -0,0 +1,128 @@
+#ifndef _LOG_H_
+#define _LOG_H_
+
+#include "BoardMove.h"
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+enum class LogLevel
+{
+	Debug,
+	Info,
+	Warning,
+	Error
+};
+
+// Lowest level of the messages that are compiled in, the calls of lower levels are removed by the compiler
+#ifndef LOG_LEVEL
+#ifdef DEBUG_OUTPUT
+#define LOG_LEVEL 0
+#else
+#define LOG_LEVEL 1
+#endif
+#endif
+
+// Logs a message where each {} in the format is replaced by the next argument.
+// The format must be a string literal, the arguments are copied and formatted later by the writer thread
+#define LOG_DEBUG(...) do { if(LOG_LEVEL <= 0) { WriteLog(LogLevel::Debug, __VA_ARGS__); } } while(false)
+#define LOG_INFO(...) do { if(LOG_LEVEL <= 1) { WriteLog(LogLevel::Info, __VA_ARGS__); } } while(false)
+#define LOG_WARNING(...) do { if(LOG_LEVEL <= 2) { WriteLog(LogLevel::Warning, __VA_ARGS__); } } while(false)
+#define LOG_ERROR(...) do { if(LOG_LEVEL <= 3) { WriteLog(LogLevel::Error, __VA_ARGS__); } } while(false)
+
+// Largest number of arguments of a message
+static const unsigned int MAX_LOG_ARGUMENTS = 16;
+
+// Text arguments longer than this are truncated
+static const unsigned int MAX_LOG_TEXT = 40;
+
+// Copy of an argument of a message
+struct LogArgument
+{
+	enum class Type
+	{
+		Int,
+		UInt,
+		Double,
+		Char,
+		Bool,
+		Text,
+		Move
+	};
+
+	Type type;
+
+	union
+	{
+		std::int64_t i;
+		std::uint64_t u;
+		double d;
+	} value;
+
+	char text[MAX_LOG_TEXT];
+};
+
+// Message waiting in the buffer of its thread to be written
+struct LogRecord
+{
+	LogLevel level;
+	const char* format;
+
+	// Time on the monotonic clock in nanoseconds, the writer orders the messages of all threads by it
+	std::uint64_t time;
+
+	unsigned int argumentCount;
+	LogArgument arguments[MAX_LOG_ARGUMENTS];
+};
+
+// Returns the next free record in the buffer of the calling thread, or nullptr if the buffer is full and the message is dropped
+LogRecord* BeginLogRecord(LogLevel level, const char* format);
+
+// Hands the record returned by BeginLogRecord over to the writer thread
+void CommitLogRecord();
+
+// Writes all messages committed so far before returning
+void FlushLog();
+
+// Sets the stream the writer thread writes the messages to, standard output by default
+void SetLogStream(std::ostream* pStream);
+
+void SetLogArgument(LogArgument& argument, int value);
+void SetLogArgument(LogArgument& argument, unsigned int value);
+void SetLogArgument(LogArgument& argument, long value);
+void SetLogArgument(LogArgument& argument, unsigned long value);
+void SetLogArgument(LogArgument& argument, long long value);
+void SetLogArgument(LogArgument& argument, unsigned long long value);
+void SetLogArgument(LogArgument& argument, double value);
+void SetLogArgument(LogArgument& argument, char value);
+void SetLogArgument(LogArgument& argument, bool value);
+void SetLogArgument(LogArgument& argument, const char* value);
+void SetLogArgument(LogArgument& argument, const std::string& value);
+void SetLogArgument(LogArgument& argument, const BoardMove& value);
+
+inline void SetLogArguments(LogRecord&)
+{
+}
+
+template<class T, class... Args>
+void SetLogArguments(LogRecord& record, const T& first, const Args&... rest)
+{
+	SetLogArgument(record.arguments[record.argumentCount++], first);
+	SetLogArguments(record, rest...);
+}
+
+// Queues a message without blocking, use the LOG_ macros so that disabled levels are compiled out
+template<class... Args>
+void WriteLog(LogLevel level, const char* format, const Args&... args)
+{
+	static_assert(sizeof...(Args) <= MAX_LOG_ARGUMENTS, "Too many arguments for a log message");
+
+	LogRecord* pRecord = BeginLogRecord(level, format);
+	if(pRecord != nullptr)
+	{
+		SetLogArguments(*pRecord, args...);
+		CommitLogRecord();
+	}
+}
+
+#endif // _LOG_H_
@@ -0,0 +1,790 @@
+#include "Search.h"
+#include "Timer.h"
+#include "Heuristics.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <limits>
+#include <cstring>
+#include <cstdlib>
+#include <iterator>
+
+// A move is only dominant if every alternative scores at least this much less
+static const int EASY_MOVE_MARGIN = 150;
+
+// Smallest fraction of the nodes of an iteration the best move must take to be an easy move.
+// The best move is searched first with a full window, so it takes a fair share of the nodes even when the position is unclear
+static const double EASY_MOVE_NODE_SHARE = 0.65;
+
+// Number of iterations in a row the same move must be dominant before it is played early
+static const unsigned int EASY_MOVE_ITERATIONS = 3;
+
+// Number of nodes searched between polls of the stop flag and the deadline
+#ifdef STRICT_DEADLINE
+static const std::uint64_t STOP_CHECK_INTERVAL = 256;
+#else
+static const std::uint64_t STOP_CHECK_INTERVAL = 1024;
+#endif
+
+// History scores are kept within [-MAX_HISTORY, MAX_HISTORY]
+static const int MAX_HISTORY = 16384;
+
+// Largest bonus or malus of a single history update
+static const int MAX_HISTORY_BONUS = 1024;
+
+// Butterfly count at which a history score is halved by the normalization, rarely searched moves keep most of their score
+static const std::int64_t BUTTERFLY_SCALE = 256;
+
+// Scores further than this from zero are mate scores
+static const int MATE_BOUND = Search::MATE - 1000;
+
+// Default margins in centipawns indexed by the remaining depth
+static const int FUTILITY_MARGINS[SearchOptions::MAX_FUTILITY_DEPTH + 1] = {0, 200, 500};
+static const int RAZOR_MARGINS[SearchOptions::MAX_PRUNING_DEPTH + 1] = {0, 350, 550, 750};
+
+// Default margin in centipawns per remaining ply of reverse futility pruning
+static const int REVERSE_FUTILITY_MARGIN = 150;
+
+// Smallest remaining depth at which a node without a hash move is searched shallower first to find one
+static const int IID_MIN_DEPTH = 4;
+
+// Number of plies the internal iterative deepening search is reduced by
+static const int IID_REDUCTION = 2;
+
+// Mate scores are cached as the distance to mate from the node, not from the root
+static int ScoreToTransposition(int score, int ply)
+{
+	if(score >= MATE_BOUND)
+		return score + ply;
+
+	if(score <= -MATE_BOUND)
+		return score - ply;
+
+	return score;
+}
+
+static int ScoreFromTransposition(int score, int ply)
+{
+	if(score >= MATE_BOUND)
+		return score - ply;
+
+	if(score <= -MATE_BOUND)
+		return score + ply;
+
+	return score;
+}
+
+static unsigned int GetHistoryTableIndex(const ivec2& pos)
+{
+	return (8*(pos.x - 1) + (pos.y - 1));
+}
+
+static bool IsQuietMove(const BoardMove& move)
+{
+	return (move.capturedType == 0) && (move.specialMove != SpecialMove::Promotion);
+}
+
+// Moves the entry towards the sign of the bonus, the closer the entry is to MAX_HISTORY the smaller the step
+static void ApplyHistoryGravity(int& entry, int bonus)
+{
+	entry += bonus - (entry * std::abs(bonus)) / MAX_HISTORY;
+}
+
+SearchOptions::SearchOptions() : bPruning(true), reverseFutilityMargin(REVERSE_FUTILITY_MARGIN), bInternalIterativeDeepening(true), bEasyMove(true)
+{
+	std::copy(std::begin(FUTILITY_MARGINS), std::end(FUTILITY_MARGINS), futilityMargins.begin());
+	std::copy(std::begin(RAZOR_MARGINS), std::end(RAZOR_MARGINS), razorMargins.begin());
+}
+
+Search::Search(const Board& board, TranspositionTable& transpositionTable, TimeManager& timeManager, const std::atomic_bool& bStop,
+			   unsigned int depth, unsigned int seed, const std::atomic_bool* pPonderHit) : m_board(board), m_transpositionTable(transpositionTable),
+	m_pTimeManager(&timeManager), m_bStop(bStop), m_pPonderHit(pPonderHit), m_depth(depth), m_stats(), m_nextStopCheck(0),
+	m_nodeLimit(std::numeric_limits<std::uint64_t>::max()), m_bStopSearch(false), m_deadline(std::chrono::steady_clock::time_point::max()),
+	m_bPondering(false), m_randEngine(seed)
+{
+	ClearHistory();
+}
+
+Search::Search(const Board& board, TranspositionTable& transpositionTable, const std::atomic_bool& bStop, unsigned int seed) : m_board(board),
+	m_transpositionTable(transpositionTable), m_pTimeManager(nullptr), m_bStop(bStop), m_pPonderHit(nullptr),
+	m_depth(std::numeric_limits<unsigned int>::max()), m_stats(), m_nextStopCheck(0), m_nodeLimit(std::numeric_limits<std::uint64_t>::max()),
+	m_bStopSearch(false), m_deadline(std::chrono::steady_clock::time_point::max()), m_bPondering(false), m_randEngine(seed)
+{
+	ClearHistory();
+}
+
+bool Search::Run(int playerID, const SearchLimits& limits, BoardMove& moveOut)
+{
+	m_depth = std::numeric_limits<unsigned int>::max();
+	m_nodeLimit = std::numeric_limits<std::uint64_t>::max();
+	m_deadline = std::chrono::steady_clock::time_point::max();
+
+	if(!limits.bInfinite)
+	{
+		if(limits.depth > 0)
+		{
+			m_depth = limits.depth;
+		}
+
+		if(limits.nodes > 0)
+		{
+			m_nodeLimit = m_stats.nodes + limits.nodes;
+		}
+
+		if(limits.moveTime > 0)
+		{
+			m_deadline = std::chrono::steady_clock::now() + std::chrono::nanoseconds(limits.moveTime);
+		}
+	}
+
+	bool bFoundMove = MiniMax(playerID, false, moveOut);
+
+	m_nodeLimit = std::numeric_limits<std::uint64_t>::max();
+
+	return bFoundMove;
+}
+
+bool Search::MiniMax(int playerID, bool bCutDepth, BoardMove& moveOut, bool bTimed, bool bPonder)
+{
+	unsigned int d = 1;
+	unsigned int depthLimit = (bCutDepth ? 3 : m_depth);
+	bool bFoundMove = false;
+	unsigned int easyIterations = 0;
+	bool bEasyMoveShare = false;
+	BoardMove lastBestMove;
+
+	// The timed search stops at the hard limit, other searches run until the stop flag is raised or their deadline passes
+	bTimed = bTimed && (m_pTimeManager != nullptr);
+	if(bTimed)
+	{
+		m_deadline = m_pTimeManager->GetDeadline();
+	}
+
+	m_nextStopCheck = std::min(m_stats.nodes + STOP_CHECK_INTERVAL, m_nodeLimit);
+	m_bStopSearch = false;
+	bPonder = bPonder && (m_pPonderHit != nullptr) && (m_pTimeManager != nullptr);
+	m_bPondering = bPonder;
+	
+	AgeHistory();
+
+	// The root moves are ordered once, each iteration orders them for the next from what it learned
+	TranspositionEntry entry;
+	bool bHashMove = m_transpositionTable.Probe(m_board.GetHash(), entry) && entry.bHasMove;
+
+	m_rootMoves.clear();
+	for(const BoardMove& move : MoveOrdering(playerID, m_board.GetMoves(playerID), false, bHashMove ? &entry.bestMove : nullptr))
+	{
+		m_rootMoves.push_back(RootMove(move));
+	}
+	
+	Timer minimaxTimer;
+	minimaxTimer.Start();
+
+	// Statistics are written per iteration, labeled with the kind of search they belong to
+	const char* searchType = bPonder ? "ponder" : (bTimed ? "timed" : "fixed");
+	std::uint64_t previousIterationNodes = 0;
+
+	// Loop until the depth limit is reached, or the shortest mate is proven
+	while(d <= depthLimit)
+	{
+		PollPonderHit();
+		bTimed = bTimed || (bPonder && !m_bPondering);
+
+		// Do not start an iteration which is not expected to finish in time
+		if(bTimed && bFoundMove && !m_pTimeManager->ShouldStartIteration())
+			break;
+
+		SearchStats iterationStart = m_stats;
+		Timer iterationTimer;
+		iterationTimer.Start();
+
+		// The alternatives are only verified to be far behind once the best move took most of the nodes of the last iteration as well,
+		// and only a timed search can play an easy move early
+		IterationResult result;
+		bool bFoundAtDepth = MiniMax(d, playerID, moveOut, result, bTimed && m_options.bEasyMove && bEasyMoveShare);
+		
+		if(bFoundAtDepth)
+		{
+			SearchStats iterationStats = m_stats - iterationStart;
+			WriteIterationStats(searchType, d, result.score, moveOut, iterationStats, previousIterationNodes, iterationTimer.GetTime());
+			previousIterationNodes = iterationStats.nodes;
+
+			LOG_DEBUG("Depth {} time: {}", d, minimaxTimer.GetTime());
+			// Count the iterations in a row where the same move stayed far ahead of every alternative
+			bEasyMoveShare = (result.bestMoveNodeShare >= EASY_MOVE_NODE_SHARE);
+			if(result.bBestMoveDominant)
+			{
+				easyIterations = ((easyIterations > 0) && (moveOut == lastBestMove)) ? (easyIterations + 1) : 1;
+			}
+			else
+			{
+				easyIterations = 0;
+			}
+
+			lastBestMove = moveOut;
+
+			if(bTimed)
+			{
+				m_pTimeManager->OnIterationComplete(moveOut, result.score);
+
+				if(easyIterations >= EASY_MOVE_ITERATIONS)
+				{
+					LOG_DEBUG("Easy move at depth {}", d);
+					m_pTimeManager->OnEasyMove();
+				}
+			}
+
+			bFoundMove = true;
+
+			// Every mate within d plies has been searched, so a deeper search cannot find a shorter one
+			if(std::abs(result.score) >= (MATE - int(d)))
+			{
+				LOG_DEBUG("Mate in {} proven at depth {}", (MATE - std::abs(result.score) + 1) / 2, d);
+				break;
+			}
+		}
+		else
+		{
+			LOG_DEBUG("No move was found at depth {}", d);
+
+			// A stopped first iteration is discarded, and the first move in the root ordering is played so that there is always a move
+			if(!bFoundMove && !m_rootMoves.empty())
+			{
+				moveOut = m_rootMoves.front().move;
+				bFoundMove = true;
+			}
+
+			break;
+		}
+
+		++d;
+	}
+
+#ifdef DEBUG_OUTPUT
+	if(m_bStopSearch)
+	{
+		auto exitTime = std::chrono::steady_clock::now();
+		if(exitTime >= m_deadline)
+		{
+			LOG_DEBUG("Stop latency: {}us", std::chrono::duration_cast<std::chrono::microseconds>(exitTime - m_deadline).count());
+		}
+	}
+#endif
+	
+	return bFoundMove;
+}
+
+bool Search::MiniMax(int depth, int playerID, BoardMove& moveOut, IterationResult& resultOut, bool bVerifyEasyMove)
+{
+	bool bFoundMove = false;
+	BoardMove bestMove;
+
+	std::uint64_t bestMoveNodes = 0;
+	std::uint64_t totalNodes = 0;
+
+	int alpha = std::numeric_limits<int>::min() + 1;
+	int beta = std::numeric_limits<int>::max();
+
+	for(RootMove& rootMove : m_rootMoves)
+	{
+		std::uint64_t moveNodes = m_stats.nodes;
+
+		m_board.MakeMove(rootMove.move);
+		int val = MiniMax(depth - 1, 1, playerID, !playerID, alpha, beta);
+		m_board.UnmakeMove(rootMove.move);
+
+		// The score of an interrupted search cannot be trusted
+		if(m_bStopSearch)
+		{
+			bFoundMove = false;
+			break;
+		}
+
+		rootMove.previousScore = rootMove.score;
+		rootMove.score = val;
+		rootMove.nodes = m_stats.nodes - moveNodes;
+		totalNodes += rootMove.nodes;
+
+		// If the new move is better than the last
+		if(val > alpha)
+		{
+			alpha = val;
+			bestMove = rootMove.move;
+			bestMoveNodes = rootMove.nodes;
+			bFoundMove = true;
+
+			LOG_DEBUG("{}", val);
+		}
+	}
+
+	if(!bFoundMove)
+		return false;
+
+	double bestMoveNodeShare = double(bestMoveNodes) / std::max<std::uint64_t>(totalNodes, 1);
+
+	// When the best move took a large share of the effort, verify with null window searches that no other move comes within EASY_MOVE_MARGIN of it
+	bool bDominant = bVerifyEasyMove && (depth >= 2) && (bestMoveNodeShare >= EASY_MOVE_NODE_SHARE);
+	int margin = alpha - EASY_MOVE_MARGIN;
+
+	for(auto iter = m_rootMoves.begin(); bDominant && (iter != m_rootMoves.end()); ++iter)
+	{
+		if(iter->move != bestMove)
+		{
+			m_board.MakeMove(iter->move);
+			bDominant = (MiniMax(depth - 1, 1, playerID, !playerID, margin - 1, margin) < margin);
+			m_board.UnmakeMove(iter->move);
+
+			if(m_bStopSearch)
+			{
+				bDominant = false;
+			}
+		}
+	}
+
+	// The moves which needed the most effort to refute are the most likely to become the best move
+	std::stable_sort(m_rootMoves.begin(), m_rootMoves.end(), [&bestMove](const RootMove& a, const RootMove& b) -> bool
+	{
+		if((a.move == bestMove) != (b.move == bestMove))
+			return a.move == bestMove;
+
+		return a.nodes > b.nodes;
+	});
+
+	UpdateHistory(playerID, bestMove, FRONTIER_TYPE(), depth);
+	StoreTransposition(m_board.GetHash(), depth, 0, alpha, ScoreBound::Exact, &bestMove, true);
+	moveOut = bestMove;
+
+	resultOut.score = alpha;
+	resultOut.bestMoveNodeShare = bestMoveNodeShare;
+	resultOut.bBestMoveDominant = bDominant;
+
+	return true;
+}
+
+bool Search::ScoreRootMoves(int depth, int playerID, std::vector<std::pair<int, BoardMove>>& movesOut)
+{
+	m_nextStopCheck = std::min(m_stats.nodes + STOP_CHECK_INTERVAL, m_nodeLimit);
+	m_bStopSearch = false;
+
+	movesOut.clear();
+
+	for(const BoardMove& move : MoveOrdering(playerID, m_board.GetMoves(playerID)))
+	{
+		m_board.MakeMove(move);
+		int score = MiniMax(depth - 1, 1, playerID, !playerID, std::numeric_limits<int>::min() + 1, std::numeric_limits<int>::max());
+		m_board.UnmakeMove(move);
+
+		if(m_bStopSearch)
+			return false;
+
+		movesOut.push_back({score, move});
+	}
+
+	std::stable_sort(movesOut.begin(), movesOut.end(), [](const std::pair<int, BoardMove>& a, const std::pair<int, BoardMove>& b) -> bool
+	{
+		return a.first > b.first;
+	});
+
+	return true;
+}
+
+int Search::MiniMax(int depth, int ply, int playerID, int playerIDToMove, int alpha, int beta)
+{
+	++m_stats.nodes;
+
+	if(depth <= 0)
+	{
+		++m_stats.qnodes;
+	}
+
+	if(IsSearchStopped())
+		return 0;
+
+	// Generate the moves for this node once, they are reused to detect the end of the game and to build the frontier
+	FRONTIER_TYPE moves;
+	bool bInCheck = false;
+	PositionStatus status = m_board.GetPositionStatus(playerIDToMove, moves, bInCheck);
+
+	// If a checkmate has been found, return a large number which prefers the shortest mate
+	if(status == PositionStatus::Checkmate)
+	{
+		if(playerIDToMove == playerID)
+			return -(MATE - ply);
+
+		return (MATE - ply);
+	}
+
+	// If a stalemate is found, return 0 which is neutral for both sides
+	if(status == PositionStatus::Stalemate)
+		return 0;
+
+	bool bMaxNode = (playerID == playerIDToMove);
+
+	// Mate distance pruning, no score can be better than mating on the next move or worse than being mated on this one
+	if(bMaxNode)
+	{
+		alpha = std::max(alpha, -(MATE - ply));
+		beta = std::min(beta, MATE - ply - 1);
+	}
+	else
+	{
+		alpha = std::max(alpha, -(MATE - ply - 1));
+		beta = std::min(beta, MATE - ply);
+	}
+
+	if(alpha >= beta)
+		return bMaxNode ? alpha : beta;
+
+	// Scores are cached from the perspective of the player to move, convert them to and from the perspective of playerID
+	std::uint64_t hash = m_board.GetHash();
+	TranspositionEntry entry;
+	bool bHashMove = false;
+
+	if((depth > 0) && m_transpositionTable.Probe(hash, entry))
+	{
+		bHashMove = entry.bHasMove;
+
+		if(entry.depth >= depth)
+		{
+			int score = ScoreFromTransposition(bMaxNode ? entry.score : -entry.score, ply);
+			ScoreBound bound = entry.bound;
+			if(!bMaxNode && (bound != ScoreBound::Exact))
+			{
+				bound = (bound == ScoreBound::Lower) ? ScoreBound::Upper : ScoreBound::Lower;
+			}
+
+			if((bound == ScoreBound::Exact) || ((bound == ScoreBound::Lower) && (score >= beta)) || ((bound == ScoreBound::Upper) && (score <= alpha)))
+			{
+				++m_stats.transpositionCutoffs;
+				return score;
+			}
+		}
+	}
+
+	// Shallow nodes far outside of the window are pruned on their static evaluation
+	// The evaluation and the window are taken from the perspective of the player to move
+	int sign = bMaxNode ? 1 : -1;
+	int moverAlpha = bMaxNode ? alpha : -beta;
+	int moverBeta = bMaxNode ? beta : -alpha;
+	bool bFutile = false;
+
+	// Nodes with an open window can be on the principal variation, their exact score is needed so they are not cut on the static evaluation
+	bool bPVNode = (alpha < (beta - 1));
+
+	if(m_options.bPruning && (depth > 0) && (depth <= SearchOptions::MAX_PRUNING_DEPTH) && !bInCheck)
+	{
+		int staticEval = sign * m_board.GetWorth(playerID, ChessHeuristic());
+
+		// Reverse futility, the player to move stays above beta even after giving up the margin
+		int reverseFutilityScore = staticEval - (m_options.reverseFutilityMargin * depth);
+		if(!bPVNode && (std::abs(moverBeta) < MATE_BOUND) && (reverseFutilityScore >= moverBeta))
+		{
+			++m_stats.reverseFutility;
+			return sign * reverseFutilityScore;
+		}
+
+		if(std::abs(moverAlpha) < MATE_BOUND)
+		{
+			// Razoring, this far below alpha only captures can help, so check with a quiescence search
+			if(!bPVNode && ((staticEval + m_options.razorMargins[depth]) <= moverAlpha))
+			{
+				int score = MiniMax(0, ply, playerID, playerIDToMove, alpha, beta);
+				if((sign * score) <= moverAlpha)
+				{
+					++m_stats.razoring;
+					return score;
+				}
+			}
+
+			// Futility, quiet moves which do not give check cannot raise the score above alpha
+			bFutile = (depth <= SearchOptions::MAX_FUTILITY_DEPTH) && ((staticEval + m_options.futilityMargins[depth]) <= moverAlpha);
+		}
+	}
+
+	// If this is a leaf node
+	if(depth <= 0)
+	{
+		// Initiate quiescent search
+
+		// Get the heuristic value of the node
+		int stand_pat = m_board.GetWorth(playerID, ChessHeuristic());
+		
+		if(depth <= -2)
+			return stand_pat;					
+
+		if(playerID == playerIDToMove)
+		{
+			if(stand_pat >= beta)
+			{
+				return stand_pat;
+			}
+
+			// See if we can do better than alpha
+			if(stand_pat > alpha)
+			{
+				alpha = stand_pat;
+			}
+		}
+		else
+		{
+			if(stand_pat <= alpha)
+			{
+				return stand_pat;
+			}
+			// See if we can do better than beta
+			if(stand_pat < beta)
+			{
+				beta = stand_pat;
+			}
+		}
+	}		
+
+	// Internal iterative deepening, a node with a full window and no hash move is searched shallower first to find a move to search first
+	if(m_options.bInternalIterativeDeepening && !bHashMove && (depth >= IID_MIN_DEPTH) && ((beta - alpha) > 1))
+	{
+		MiniMax(depth - IID_REDUCTION, ply, playerID, playerIDToMove, alpha, beta);
+		bHashMove = m_transpositionTable.Probe(hash, entry) && entry.bHasMove;
+	}
+
+	// Build a priority queue of the frontier nodes
+	// If we are applying Quiescence Search, only look at attacking moves which do not lose material
+	FRONTIER_TYPE frontier = MoveOrdering(playerIDToMove, std::move(moves), depth <= 0, bHashMove ? &entry.bestMove : nullptr);
+
+	BoardMove bestMove;
+	bool bFoundBestMove = false;
+
+	// Quiet moves searched so far, they are punished when a later move turns out to be best
+	FRONTIER_TYPE quietMoves;
+	unsigned int searchedMoves = 0;
+
+	for(const BoardMove& currentMove : frontier)
+	{
+		// Apply the move in the queue with the highest priority
+		m_board.MakeMove(currentMove);
+
+		if(bFutile && IsQuietMove(currentMove) && !m_board.IsInCheck(!playerIDToMove))
+		{
+			m_board.UnmakeMove(currentMove);
+			++m_stats.futility;
+			continue;
+		}
+
+		int score = MiniMax(depth - 1, ply + 1, playerID, !playerIDToMove, alpha, beta);
+		m_board.UnmakeMove(currentMove);
+		++searchedMoves;
+
+		if(IsQuietMove(currentMove))
+		{
+			++m_history.butterfly[playerIDToMove][GetHistoryTableIndex(currentMove.from)][GetHistoryTableIndex(currentMove.to)];
+		}
+
+		if(playerID == playerIDToMove)
+		{
+			if(score >= beta)
+			{
+				CountCutoff(searchedMoves);
+				UpdateHistory(playerIDToMove, currentMove, quietMoves, depth);
+				StoreTransposition(hash, depth, ply, score, ScoreBound::Lower, &currentMove, bMaxNode);
+				return score;
+			}
+			
+			if(score > alpha)
+			{
+				alpha = score;
+				bestMove = currentMove;
+				bFoundBestMove = true;
+			}			
+		}
+		else
+		{
+			if(score <= alpha)
+			{
+				CountCutoff(searchedMoves);
+				UpdateHistory(playerIDToMove, currentMove, quietMoves, depth);
+				StoreTransposition(hash, depth, ply, score, ScoreBound::Upper, &currentMove, bMaxNode);
+				return score;
+			}
+			
+			if(score < beta)
+			{
+				beta = score;
+				bestMove = currentMove;
+				bFoundBestMove = true;
+			}
+		}
+
+		if(IsQuietMove(currentMove))
+		{
+			quietMoves.push_back(currentMove);
+		}
+	}
+
+	if(bFoundBestMove)
+	{
+		UpdateHistory(playerIDToMove, bestMove, quietMoves, depth);
+	}
+
+	// When no move improved the window, the score is only a bound on the real score
+	int score = bMaxNode ? alpha : beta;
+	ScoreBound bound = bFoundBestMove ? ScoreBound::Exact : (bMaxNode ? ScoreBound::Upper : ScoreBound::Lower);
+	StoreTransposition(hash, depth, ply, score, bound, bFoundBestMove ? &bestMove : nullptr, bMaxNode);
+		
+	return score;
+}
+
+void Search::CountCutoff(unsigned int searchedMoves)
+{
+	++m_stats.betaCutoffs;
+	if(searchedMoves == 1)
+	{
+		++m_stats.firstMoveCutoffs;
+	}
+}
+
+void Search::StoreTransposition(std::uint64_t hash, int depth, int ply, int score, ScoreBound bound, const BoardMove* pBestMove, bool bMaxNode)
+{
+	// Quiescence nodes are not cached, and the score of an interrupted search cannot be trusted
+	if((depth <= 0) || m_bStopSearch)
+		return;
+
+	TranspositionEntry entry;
+	entry.depth = depth;
+	entry.score = ScoreToTransposition(bMaxNode ? score : -score, ply);
+	entry.bound = bound;
+
+	if(!bMaxNode && (bound != ScoreBound::Exact))
+	{
+		entry.bound = (bound == ScoreBound::Lower) ? ScoreBound::Upper : ScoreBound::Lower;
+	}
+
+	if(pBestMove != nullptr)
+	{
+		entry.bestMove = *pBestMove;
+		entry.bHasMove = true;
+	}
+
+	m_transpositionTable.Store(hash, entry);
+}
+
+bool Search::IsSearchStopped()
+{
+	if(!m_bStopSearch && (m_stats.nodes >= m_nextStopCheck))
+	{
+		// The node limit is checked exactly, so that node limited searches are reproducible
+		m_nextStopCheck = std::min(m_stats.nodes + STOP_CHECK_INTERVAL, m_nodeLimit);
+
+		// The flag only needs to be seen eventually, so a relaxed load is enough
+		PollPonderHit();
+		m_bStopSearch = (m_stats.nodes >= m_nodeLimit) || m_bStop.load(std::memory_order_relaxed) || (std::chrono::steady_clock::now() >= m_deadline);
+	}
+
+	return m_bStopSearch;
+}
+
+void Search::PollPonderHit()
+{
+	// The time manager was started before the hit was signaled, so its limits are visible after the acquire
+	if(m_bPondering && m_pPonderHit->load(std::memory_order_acquire))
+	{
+		m_bPondering = false;
+		m_deadline = m_pTimeManager->GetDeadline();
+	}
+}
+
+Search::FRONTIER_TYPE Search::MoveOrdering(int playerIDToMove, FRONTIER_TYPE moves, bool bCapturesOnly, const BoardMove* pHashMove)
+{
+	// Captures are bucketed above or below every history score depending on their SEE
+	const std::int64_t captureBucket = std::int64_t(1) << 40;
+
+	std::shuffle(moves.begin(), moves.end(), m_randEngine);
+
+	std::vector<std::pair<std::int64_t, BoardMove>> scoredMoves;
+	scoredMoves.reserve(moves.size());
+
+	for(const BoardMove& move : moves)
+	{
+		// The hash move is only used if it is one of the valid moves, which guards against key collisions
+		if((pHashMove != nullptr) && (move == *pHashMove))
+		{
+			scoredMoves.push_back({std::numeric_limits<std::int64_t>::max(), move});
+		}
+		else if((move.capturedType != 0) || (move.specialMove == SpecialMove::Promotion))
+		{
+			int see = m_board.SEE(move);
+			if(see >= 0)
+			{
+				scoredMoves.push_back({captureBucket + see, move});
+			}
+			else if(!bCapturesOnly)
+			{
+				scoredMoves.push_back({-captureBucket + see, move});
+			}
+		}
+		else if(!bCapturesOnly)
+		{
+			// Moves which are searched often collect more bonuses, so damp their scores by how often they were searched
+			unsigned int from = GetHistoryTableIndex(move.from);
+			unsigned int to = GetHistoryTableIndex(move.to);
+			std::int64_t score = (m_history.scores[playerIDToMove][from][to] * BUTTERFLY_SCALE) / (BUTTERFLY_SCALE + m_history.butterfly[playerIDToMove][from][to]);
+
+			scoredMoves.push_back({score, move});
+		}
+	}
+
+	std::sort(scoredMoves.begin(), scoredMoves.end(), [](const std::pair<std::int64_t, BoardMove>& a, const std::pair<std::int64_t, BoardMove>& b) -> bool
+	{
+		return a.first > b.first;
+	});
+
+	FRONTIER_TYPE frontier;
+	frontier.reserve(scoredMoves.size());
+
+	for(const auto& iter : scoredMoves)
+	{
+		frontier.push_back(iter.second);
+	}
+
+	return frontier;
+}
+
+void Search::ClearHistory()
+{
+	std::memset(&m_history, 0, sizeof(m_history));
+}
+
+void Search::AgeHistory()
+{
+	for(HISTORY_ARRAY_TYPE* pTable : {&m_history.scores, &m_history.butterfly})
+	{
+		for(auto& player : *pTable)
+		{
+			for(auto& from : player)
+			{
+				for(int& value : from)
+				{
+					value /= 2;
+				}
+			}
+		}
+	}
+}
+
+void Search::UpdateHistory(int playerIDToMove, const BoardMove& bestMove, const FRONTIER_TYPE& quietMoves, int depth)
+{
+	// Captures are ordered by SEE, so only quiet moves are tracked
+	if(!IsQuietMove(bestMove) || (depth <= 0))
+		return;
+
+	int bonus = std::min((depth * depth) + depth, MAX_HISTORY_BONUS);
+
+	auto& scores = m_history.scores[playerIDToMove];
+	ApplyHistoryGravity(scores[GetHistoryTableIndex(bestMove.from)][GetHistoryTableIndex(bestMove.to)], bonus);
+
+	for(const BoardMove& move : quietMoves)
+	{
+		if(move != bestMove)
+		{
+			ApplyHistoryGravity(scores[GetHistoryTableIndex(move.from)][GetHistoryTableIndex(move.to)], -bonus);
+		}
+	}
+}
@@ -0,0 +1,225 @@
+#ifndef _SEARCH_H_
+#define _SEARCH_H_
+
+#include "Board.h"
+#include "SearchStats.h"
+#include "TimeManager.h"
+#include "TranspositionTable.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <utility>
+#include <vector>
+
+// Limits of a search that does not depend on the game clock, a limit of 0 does not limit the search
+struct SearchLimits
+{
+	SearchLimits() : depth(0), nodes(0), moveTime(0), bInfinite(false)
+	{
+	}
+
+	// Deepest iteration of iterative deepening
+	unsigned int depth;
+
+	// Number of nodes after which the search stops
+	std::uint64_t nodes;
+
+	// Time in nanoseconds after which the search stops
+	std::uint64_t moveTime;
+
+	// Ignores the other limits, the search only ends once the stop flag is raised or the shortest mate is proven
+	bool bInfinite;
+};
+
+// Switches and margins of the selective parts of the search, the defaults are the values the engine plays with
+struct SearchOptions
+{
+	// Deepest remaining depth at which nodes are pruned on their static evaluation
+	static const int MAX_PRUNING_DEPTH = 3;
+
+	// Deepest remaining depth at which quiet moves are skipped by futility pruning
+	static const int MAX_FUTILITY_DEPTH = 2;
+
+	SearchOptions();
+
+	// Enables reverse futility pruning, razoring and futility pruning
+	bool bPruning;
+
+	// Margins in centipawns indexed by the remaining depth
+	std::array<int, MAX_FUTILITY_DEPTH + 1> futilityMargins;
+	std::array<int, MAX_PRUNING_DEPTH + 1> razorMargins;
+
+	// Margin in centipawns per remaining ply of reverse futility pruning
+	int reverseFutilityMargin;
+
+	// Enables searching nodes without a hash move shallower first to find one
+	bool bInternalIterativeDeepening;
+
+	// Enables stopping a timed search early when the same move stays dominant
+	bool bEasyMove;
+};
+
+// Searches a position for the best move.
+// Each thread searches with its own Search, which owns a copy of the board, the history table and the node counter.
+// The transposition table, the time manager and the stop flag are shared
+class Search
+{
+public:
+
+	// Score of checkmating the opponent on the root, a mate n plies from the root scores MATE - n
+	static const int MATE = 1000000;
+
+	// Seed of the move shuffle of searches which are not given one
+	static const unsigned int DEFAULT_SEED = 1;
+
+	typedef std::array<std::array<std::array<int,64>,64>,2> HISTORY_ARRAY_TYPE;
+	typedef std::vector<BoardMove> FRONTIER_TYPE;
+
+	// Move ordering statistics of quiet moves, indexed by player, from tile and to tile
+	struct HistoryTable
+	{
+		// Bonuses of the moves that were best, minus maluses of the moves searched before them, kept within MAX_HISTORY by gravity
+		HISTORY_ARRAY_TYPE scores;
+
+		// Number of times each move was searched, the scores are normalized by it
+		HISTORY_ARRAY_TYPE butterfly;
+	};
+
+	// A move of the root kept across the iterations of a search
+	struct RootMove
+	{
+		explicit RootMove(const BoardMove& m) : move(m), score(0), previousScore(0), nodes(0)
+		{
+		}
+
+		BoardMove move;
+
+		// Score of the last completed iteration and of the one before it, only the score of the best move is exact, the others are upper bounds
+		int score;
+		int previousScore;
+
+		// Number of nodes searched below the move in the last completed iteration
+		std::uint64_t nodes;
+	};
+
+	// Summary of a completed iteration at the root
+	struct IterationResult
+	{
+		// Score of the best move
+		int score;
+
+		// Fraction of the nodes of the iteration spent searching the best move
+		double bestMoveNodeShare;
+
+		// True if the dominance of the best move was verified and every other move scored at least EASY_MOVE_MARGIN below it
+		bool bBestMoveDominant;
+	};
+
+	// Constructs a search of the board limited to depth plies, which stops once bStop is raised.
+	// A ponder search is handed over to the time manager once pPonderHit is raised
+	Search(const Board& board, TranspositionTable& transpositionTable, TimeManager& timeManager, const std::atomic_bool& bStop,
+		   unsigned int depth, unsigned int seed, const std::atomic_bool* pPonderHit = nullptr);
+
+	// Constructs a search of the board without a time manager, which is limited by the limits passed to Run and stops once bStop is raised
+	Search(const Board& board, TranspositionTable& transpositionTable, const std::atomic_bool& bStop, unsigned int seed = DEFAULT_SEED);
+
+	// Finds the best move of the player until one of the limits is reached.
+	// Searches with the same seed and the same depth or node limit visit the same nodes and find the same move
+	bool Run(int playerID, const SearchLimits& limits, BoardMove& moveOut);
+
+	// Finds the best move from minimax with alpha beta pruning, Quiescence Search, Transposition Table, and History Table
+	// If bTimed is true and the search has a time manager, it decides when to stop iterative deepening.
+	// If bPonder is true, the search runs until it is stopped, its deadline passes, or a ponder hit turns it into a timed search.
+	// The limits are polled from the first iteration on, if it is stopped the first move of the root ordering is returned
+	bool MiniMax(int playerID, bool bCutDepth, BoardMove& moveOut, bool bTimed = false, bool bPonder = false);
+
+	// Scores every move of the player with a full window search to the depth, sorted from best to worst
+	// Returns false if the search was stopped before all moves were scored
+	bool ScoreRootMoves(int depth, int playerID, std::vector<std::pair<int, BoardMove>>& movesOut);
+
+	// Orders the valid moves of the current player to move into the frontier nodes.
+	// The hash move comes first, then captures that do not lose material ordered by SEE, then quiet moves sorted from high to low based on the normalized history table, then losing captures.
+	// If bCapturesOnly is true, only the captures and promotions that do not lose material are returned
+	FRONTIER_TYPE MoveOrdering(int playerIDToMove, FRONTIER_TYPE moves, bool bCapturesOnly = false, const BoardMove* pHashMove = nullptr);
+
+	const SearchOptions& GetOptions() const { return m_options; }
+	void SetOptions(const SearchOptions& options) { m_options = options; }
+
+	// Sets the time at which a search which is not timed stops
+	void SetDeadline(std::chrono::steady_clock::time_point deadline) { m_deadline = deadline; }
+
+	// Returns true if the last ponder search ended before the ponder hit was signaled
+	bool IsPondering() const { return m_bPondering; }
+
+	Board& GetBoard() { return m_board; }
+
+	const HistoryTable& GetHistory() const { return m_history; }
+	void SetHistory(const HistoryTable& history) { m_history = history; }
+
+	// Clears all entries in the history table
+	void ClearHistory();
+
+	// Returns the number of nodes searched
+	std::uint64_t GetNodes() const { return m_stats.nodes; }
+
+	// Returns the counters accumulated over all searches of this object
+	const SearchStats& GetStats() const { return m_stats; }
+
+	// Returns the moves of the root ordered as the next iteration would search them, the best move of the last iteration comes first
+	const std::vector<RootMove>& GetRootMoves() const { return m_rootMoves; }
+
+private:
+
+	// Searches every root move to the depth, then orders the root moves for the next iteration by the best move first and the rest by their node counts.
+	// If bVerifyEasyMove is true and the best move took a large share of the nodes, the other moves are searched with null windows to find whether it is dominant
+	bool MiniMax(int depth, int playerID, BoardMove& moveOut, IterationResult& resultOut, bool bVerifyEasyMove);
+	int MiniMax(int depth, int ply, int playerID, int playerIDToMove, int a, int b);
+
+	// Caches the result of a node ply moves from the root, bMaxNode is true if the player to move is the player the score is from the perspective of
+	void StoreTransposition(std::uint64_t hash, int depth, int ply, int score, ScoreBound bound, const BoardMove* pBestMove, bool bMaxNode);
+
+	// Counts a cutoff of a node that happened after searching searchedMoves moves
+	void CountCutoff(unsigned int searchedMoves);
+
+	// Halves all entries in the history table, so that the ordering learned by the last search is kept but does not dominate
+	void AgeHistory();
+
+	// Rewards the best move of a node and punishes the quiet moves that were searched before it, scaled by the depth
+	void UpdateHistory(int playerIDToMove, const BoardMove& bestMove, const FRONTIER_TYPE& quietMoves, int depth);
+
+	// Returns true if the search has to stop because the stop flag was raised or the deadline has passed.
+	// The flag and the clock are only polled every STOP_CHECK_INTERVAL nodes
+	bool IsSearchStopped();
+
+	// Hands a ponder search over to the time manager once the ponder hit has been signaled
+	void PollPonderHit();
+
+private:
+
+	Board m_board;
+	TranspositionTable& m_transpositionTable;
+	TimeManager* m_pTimeManager;
+	const std::atomic_bool& m_bStop;
+	const std::atomic_bool* m_pPonderHit;
+
+	unsigned int m_depth;
+	SearchOptions m_options;
+	SearchStats m_stats;
+
+	// Polling state of the running search
+	std::uint64_t m_nextStopCheck;
+	std::uint64_t m_nodeLimit;
+	bool m_bStopSearch;
+	std::chrono::steady_clock::time_point m_deadline;
+	bool m_bPondering;
+
+	// Moves of the root, reordered after every completed iteration
+	std::vector<RootMove> m_rootMoves;
+
+	HistoryTable m_history;
+
+	std::default_random_engine m_randEngine;
+};
+
+#endif // _SEARCH_H_
@@ -0,0 +1,46 @@
+#include "SearchStats.h"
+#include "Log.h"
+#include <atomic>
+
+#ifdef DEBUG_OUTPUT
+static std::atomic_bool s_bEnabled(true);
+#else
+static std::atomic_bool s_bEnabled(false);
+#endif
+
+SearchStats operator-(const SearchStats& a, const SearchStats& b)
+{
+	SearchStats stats;
+	stats.nodes = a.nodes - b.nodes;
+	stats.qnodes = a.qnodes - b.qnodes;
+	stats.betaCutoffs = a.betaCutoffs - b.betaCutoffs;
+	stats.firstMoveCutoffs = a.firstMoveCutoffs - b.firstMoveCutoffs;
+	stats.transpositionCutoffs = a.transpositionCutoffs - b.transpositionCutoffs;
+	stats.futility = a.futility - b.futility;
+	stats.reverseFutility = a.reverseFutility - b.reverseFutility;
+	stats.razoring = a.razoring - b.razoring;
+
+	return stats;
+}
+
+void SetSearchStatsEnabled(bool bEnabled)
+{
+	s_bEnabled = bEnabled;
+}
+
+void WriteIterationStats(const char* searchType, unsigned int depth, int score, const BoardMove& bestMove,
+						 const SearchStats& stats, std::uint64_t previousNodes, std::uint64_t time)
+{
+	if(!s_bEnabled)
+		return;
+
+	double firstMoveCutoffRate = (stats.betaCutoffs > 0) ? (double(stats.firstMoveCutoffs) / stats.betaCutoffs) : 0.0;
+	double branchingFactor = (previousNodes > 0) ? (double(stats.nodes) / previousNodes) : 0.0;
+	std::uint64_t nodesPerSecond = (time > 0) ? std::uint64_t(stats.nodes * 1000000000.0 / time) : 0;
+
+	LOG_INFO("search={} depth={} score={} move={} nodes={} qnodes={} cutoffs={} first_move_cutoffs={} first_move_cutoff_rate={} "
+			 "tt_cutoffs={} futility={} reverse_futility={} razoring={} ebf={} time_ms={} nps={}",
+			 searchType, depth, score, bestMove, stats.nodes, stats.qnodes, stats.betaCutoffs, stats.firstMoveCutoffs, firstMoveCutoffRate,
+			 stats.transpositionCutoffs,
+			 stats.futility, stats.reverseFutility, stats.razoring, branchingFactor, time / 1000000, nodesPerSecond);
+}
@@ -0,0 +1,44 @@
+#ifndef _SEARCHSTATS_H_
+#define _SEARCHSTATS_H_
+
+#include "BoardMove.h"
+#include <cstdint>
+
+// Counters of a search.
+// Each search thread owns its own counters, so they are incremented without atomics or locks
+struct SearchStats
+{
+	SearchStats() : nodes(0), qnodes(0), betaCutoffs(0), firstMoveCutoffs(0), transpositionCutoffs(0),
+		futility(0), reverseFutility(0), razoring(0)
+	{
+	}
+
+	// Number of nodes searched, including the quiescence nodes
+	std::uint64_t nodes;
+	std::uint64_t qnodes;
+
+	// Number of nodes cut off by a move, and how many of them were cut off by the first move searched
+	std::uint64_t betaCutoffs;
+	std::uint64_t firstMoveCutoffs;
+
+	// Number of nodes answered by the transposition table
+	std::uint64_t transpositionCutoffs;
+
+	// Number of nodes cut by each kind of shallow pruning
+	std::uint64_t futility;
+	std::uint64_t reverseFutility;
+	std::uint64_t razoring;
+};
+
+// Returns the counters accumulated between the two snapshots
+SearchStats operator-(const SearchStats& a, const SearchStats& b);
+
+// Enables the line of statistics written to the log for every completed iteration, enabled by default with DEBUG_OUTPUT
+void SetSearchStatsEnabled(bool bEnabled);
+
+// Writes the statistics of a completed iteration to the log as a single line of key=value pairs.
+// stats are the counters of the iteration alone, previousNodes is the number of nodes of the iteration before it and time is in nanoseconds
+void WriteIterationStats(const char* searchType, unsigned int depth, int score, const BoardMove& bestMove,
+						 const SearchStats& stats, std::uint64_t previousNodes, std::uint64_t time);
+
+#endif // _SEARCHSTATS_H_
@@ -0,0 +1,135 @@
+#include "TimeManager.h"
+#include <algorithm>
+
+// Number of moves the remaining time is divided over at the start of the game
+static const int EXPECTED_GAME_MOVES = 50;
+
+// The remaining time is never divided over fewer moves than this
+static const int MIN_MOVES_TO_GO = 20;
+
+// Time kept in reserve for the network round trip of each move in nanoseconds
+static const std::uint64_t MOVE_OVERHEAD = 100000000;
+
+// The hard limit may be at most this many times the optimum time
+static const double MAX_HARD_LIMIT_SCALE = 5.0;
+
+// The hard limit may be at most this fraction of the remaining time
+static const double MAX_REMAINING_TIME_FRACTION = 0.25;
+
+// Score drop at which the soft limit is doubled
+static const int MAX_SCORE_DROP = 300;
+
+// An easy move uses at most the optimum time divided by this
+static const std::uint64_t EASY_MOVE_TIME_DIVISOR = 5;
+
+// Branching factor used until two iterations have been timed
+static const double DEFAULT_BRANCHING_FACTOR = 4.0;
+
+// Returns the remaining time in nanoseconds without the time kept in reserve for the network
+static std::uint64_t GetUsableTime(float remainingTime)
+{
+	std::uint64_t remaining = std::uint64_t(std::max(remainingTime, 0.0f) * 1000000000.0);
+	return (remaining > MOVE_OVERHEAD) ? (remaining - MOVE_OVERHEAD) : 0;
+}
+
+TimeManager::TimeManager() : m_timeScale(1.0), m_optimumTime(0), m_softLimit(0), m_hardLimit(0), m_lastIterationTime(0),
+	m_previousIterationTime(0), m_lastIterationEnd(0), m_iterations(0), m_bestMoveChanges(0.0), m_bEasyMove(false), m_bestScore(0)
+{
+}
+
+void TimeManager::Start(float remainingTime, unsigned int movesPlayed)
+{
+	m_timer.Reset();
+	m_timer.Start();
+	m_startTime = std::chrono::steady_clock::now();
+
+	std::uint64_t remaining = GetUsableTime(remainingTime);
+
+	m_optimumTime = std::min(std::uint64_t(ComputeOptimumTime(remainingTime, movesPlayed) * m_timeScale), remaining);
+	m_hardLimit = std::min(std::uint64_t(m_optimumTime * MAX_HARD_LIMIT_SCALE), std::uint64_t(remaining * MAX_REMAINING_TIME_FRACTION));
+	m_hardLimit = std::max(m_hardLimit, m_optimumTime);
+	m_softLimit = m_optimumTime;
+
+	m_lastIterationTime = 0;
+	m_previousIterationTime = 0;
+	m_lastIterationEnd = 0;
+	m_iterations = 0;
+	m_bestMoveChanges = 0.0;
+	m_bEasyMove = false;
+	m_bestScore = 0;
+}
+
+void TimeManager::OnIterationComplete(const BoardMove& bestMove, int score)
+{
+	std::uint64_t now = m_timer.GetTime();
+
+	m_previousIterationTime = m_lastIterationTime;
+	m_lastIterationTime = now - m_lastIterationEnd;
+	m_lastIterationEnd = now;
+
+	// Older best move changes matter less than recent ones
+	m_bestMoveChanges *= 0.5;
+
+	double scoreFactor = 1.0;
+
+	if(m_iterations > 0)
+	{
+		if(bestMove != m_bestMove)
+		{
+			m_bestMoveChanges += 1.0;
+			m_bEasyMove = false;
+		}
+
+		// Spend more time when the position is getting worse
+		if(score < m_bestScore)
+		{
+			scoreFactor += double(std::min(m_bestScore - score, MAX_SCORE_DROP)) / MAX_SCORE_DROP;
+		}
+	}
+
+	m_softLimit = std::min(std::uint64_t(m_optimumTime * (1.0 + m_bestMoveChanges) * scoreFactor), m_hardLimit);
+
+	if(m_bEasyMove)
+	{
+		m_softLimit = std::min(m_softLimit, m_optimumTime / EASY_MOVE_TIME_DIVISOR);
+	}
+
+	m_bestMove = bestMove;
+	m_bestScore = score;
+	m_iterations++;
+}
+
+void TimeManager::OnEasyMove()
+{
+	m_bEasyMove = true;
+	m_softLimit = std::min(m_softLimit, m_optimumTime / EASY_MOVE_TIME_DIVISOR);
+}
+
+std::uint64_t TimeManager::ComputeOptimumTime(float remainingTime, unsigned int movesPlayed)
+{
+	// Use more of the clock per move as the game goes on
+	int movesToGo = std::max(MIN_MOVES_TO_GO, EXPECTED_GAME_MOVES - int(movesPlayed));
+
+	return GetUsableTime(remainingTime) / movesToGo;
+}
+
+bool TimeManager::ShouldStartIteration()
+{
+	std::uint64_t elapsed = m_timer.GetTime();
+	if(elapsed >= m_softLimit)
+		return false;
+
+	// Predict how long the next iteration takes from how fast the previous iterations grew
+	double branchingFactor = DEFAULT_BRANCHING_FACTOR;
+	if(m_previousIterationTime > 0)
+	{
+		branchingFactor = std::min(std::max(double(m_lastIterationTime) / m_previousIterationTime, 1.5), 10.0);
+	}
+
+	return (elapsed + std::uint64_t(m_lastIterationTime * branchingFactor)) <= m_hardLimit;
+}
+
+std::uint64_t TimeManager::GetElapsedTime()
+{
+	return m_timer.GetTime();
+}
@@ -0,0 +1,74 @@
+#ifndef _TIMEMANAGER_H_
+#define _TIMEMANAGER_H_
+
+#include "BoardMove.h"
+#include "Timer.h"
+#include <chrono>
+#include <cstdint>
+
+// Decides how long the AI should search for each move.
+// The soft limit is the time the AI aims to use and grows when the search is unstable,
+// the hard limit is the time after which the search is always stopped.
+class TimeManager
+{
+public:
+
+	TimeManager();
+
+	// Starts timing a new move and computes its limits.
+	// remainingTime is the time left on the clock in seconds and movesPlayed is the number of moves the AI has made so far
+	void Start(float remainingTime, unsigned int movesPlayed);
+
+	// Records the result of a completed iteration of iterative deepening
+	void OnIterationComplete(const BoardMove& bestMove, int score);
+
+	// Marks the best move as an easy move which does not need the full time of a stable search
+	void OnEasyMove();
+
+	// Returns true if the next iteration is expected to finish before the hard limit, and the soft limit has not been reached
+	bool ShouldStartIteration();
+
+	// Scales the optimum time of the following moves, a scale of 1 uses the time the clock allows
+	void SetTimeScale(double scale) { m_timeScale = scale; }
+
+	// Returns the time in nanoseconds that a stable search should use with remainingTime seconds left on the clock after movesPlayed moves
+	static std::uint64_t ComputeOptimumTime(float remainingTime, unsigned int movesPlayed);
+
+	// Returns the time in nanoseconds since Start() was called
+	std::uint64_t GetElapsedTime();
+
+	// Returns the time in nanoseconds that a stable search should use
+	std::uint64_t GetOptimumTime() const { return m_optimumTime; }
+
+	// Returns the time in nanoseconds that the search should use after adjusting for instability
+	std::uint64_t GetSoftLimit() const { return m_softLimit; }
+
+	// Returns the time in nanoseconds after which the search must be stopped
+	std::uint64_t GetHardLimit() const { return m_hardLimit; }
+
+	// Returns the point in time on the monotonic clock when the hard limit is reached
+	std::chrono::steady_clock::time_point GetDeadline() const { return m_startTime + std::chrono::nanoseconds(m_hardLimit); }
+
+private:
+
+	Timer m_timer;
+	std::chrono::steady_clock::time_point m_startTime;
+
+	double m_timeScale;
+	std::uint64_t m_optimumTime;
+	std::uint64_t m_softLimit;
+	std::uint64_t m_hardLimit;
+
+	// Durations of the last two iterations, used to estimate the branching factor
+	std::uint64_t m_lastIterationTime;
+	std::uint64_t m_previousIterationTime;
+	std::uint64_t m_lastIterationEnd;
+
+	unsigned int m_iterations;
+	double m_bestMoveChanges;
+	bool m_bEasyMove;
+	BoardMove m_bestMove;
+	int m_bestScore;
+};
+
+#endif // _TIMEMANAGER_H_
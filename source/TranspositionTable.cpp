@@ -0,0 +1,102 @@
+#include "TranspositionTable.h"
+#include <algorithm>
+
+// Layout of the data of a slot
+static const unsigned int FROM_SHIFT = 0;
+static const unsigned int TO_SHIFT = 6;
+static const unsigned int PROMOTION_SHIFT = 12;
+static const unsigned int HAS_MOVE_SHIFT = 20;
+static const unsigned int BOUND_SHIFT = 21;
+static const unsigned int GENERATION_SHIFT = 23;
+static const unsigned int DEPTH_SHIFT = 29;
+static const unsigned int SCORE_SHIFT = 37;
+
+static const std::uint64_t GENERATION_MASK = 0x3F;
+static const std::uint64_t DEPTH_MASK = 0xFF;
+
+// Scores are stored unsigned by adding this offset
+static const std::int64_t SCORE_OFFSET = std::int64_t(1) << 26;
+
+static std::uint64_t GetTileIndex(const ivec2& pos)
+{
+	return (8*(pos.x - 1) + (pos.y - 1));
+}
+
+static ivec2 GetTilePos(std::uint64_t index)
+{
+	return {int(index / 8) + 1, int(index % 8) + 1};
+}
+
+TranspositionTable::TranspositionTable(unsigned int sizeLog2) : m_slots(new Slot[std::size_t(1) << sizeLog2]),
+	m_mask((std::uint64_t(1) << sizeLog2) - 1), m_generation(0)
+{
+	Clear();
+}
+
+void TranspositionTable::NewSearch()
+{
+	m_generation = (m_generation + 1) & GENERATION_MASK;
+}
+
+void TranspositionTable::Clear()
+{
+	for(std::uint64_t i = 0; i <= m_mask; ++i)
+	{
+		m_slots[i].key.store(0, std::memory_order_relaxed);
+		m_slots[i].data.store(0, std::memory_order_relaxed);
+	}
+}
+
+bool TranspositionTable::Probe(std::uint64_t key, TranspositionEntry& entryOut) const
+{
+	const Slot& slot = m_slots[key & m_mask];
+	std::uint64_t data = slot.data.load(std::memory_order_relaxed);
+	std::uint64_t slotKey = slot.key.load(std::memory_order_relaxed);
+
+	if((slotKey ^ data) != key)
+		return false;
+
+	entryOut.bHasMove = ((data >> HAS_MOVE_SHIFT) & 1) != 0;
+	if(entryOut.bHasMove)
+	{
+		entryOut.bestMove.from = GetTilePos((data >> FROM_SHIFT) & 0x3F);
+		entryOut.bestMove.to = GetTilePos((data >> TO_SHIFT) & 0x3F);
+		entryOut.bestMove.promotion = int((data >> PROMOTION_SHIFT) & 0xFF);
+	}
+
+	entryOut.bound = static_cast<ScoreBound>((data >> BOUND_SHIFT) & 0x3);
+	entryOut.depth = int((data >> DEPTH_SHIFT) & DEPTH_MASK);
+	entryOut.score = int(std::int64_t(data >> SCORE_SHIFT) - SCORE_OFFSET);
+
+	return true;
+}
+
+void TranspositionTable::Store(std::uint64_t key, const TranspositionEntry& entry)
+{
+	Slot& slot = m_slots[key & m_mask];
+	std::uint64_t oldData = slot.data.load(std::memory_order_relaxed);
+	std::uint64_t oldKey = slot.key.load(std::memory_order_relaxed) ^ oldData;
+
+	// Keep a deeper entry of the current search, unless the new entry is an exact score of the same position
+	bool bOldIsCurrent = (oldData != 0) && (((oldData >> GENERATION_SHIFT) & GENERATION_MASK) == m_generation);
+	int oldDepth = int((oldData >> DEPTH_SHIFT) & DEPTH_MASK);
+	if(bOldIsCurrent && (entry.depth < oldDepth) && ((oldKey != key) || (entry.bound != ScoreBound::Exact)))
+		return;
+
+	std::uint64_t data = 0;
+	if(entry.bHasMove)
+	{
+		data |= GetTileIndex(entry.bestMove.from) << FROM_SHIFT;
+		data |= GetTileIndex(entry.bestMove.to) << TO_SHIFT;
+		data |= (std::uint64_t(entry.bestMove.promotion) & 0xFF) << PROMOTION_SHIFT;
+		data |= std::uint64_t(1) << HAS_MOVE_SHIFT;
+	}
+
+	data |= std::uint64_t(entry.bound) << BOUND_SHIFT;
+	data |= std::uint64_t(m_generation) << GENERATION_SHIFT;
+	data |= std::uint64_t(std::min(std::max(entry.depth, 0), int(DEPTH_MASK))) << DEPTH_SHIFT;
+	data |= std::uint64_t(entry.score + SCORE_OFFSET) << SCORE_SHIFT;
+
+	slot.key.store(key ^ data, std::memory_order_relaxed);
+	slot.data.store(data, std::memory_order_relaxed);
+}
@@ -0,0 +1,76 @@
+#ifndef _TRANSPOSITIONTABLE_H_
+#define _TRANSPOSITIONTABLE_H_
+
+#include "BoardMove.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+// Describes how the stored score relates to the real score of the position
+enum class ScoreBound
+{
+	Exact,
+	Lower,
+	Upper
+};
+
+// Search result of a position
+struct TranspositionEntry
+{
+	TranspositionEntry() : score(0), depth(0), bound(ScoreBound::Exact), bHasMove(false)
+	{
+	}
+
+	// Best move found, only the from, to and promotion fields are stored
+	BoardMove bestMove;
+
+	// Score from the perspective of the player to move
+	int score;
+
+	// Depth that the position was searched to
+	int depth;
+
+	ScoreBound bound;
+
+	// False if no move improved on the search window
+	bool bHasMove;
+};
+
+// Cache of search results keyed by the Zobrist hash of the position.
+// The table is shared between threads without locks, each slot stores the key xored with the data so that a torn write reads back as a miss
+class TranspositionTable
+{
+public:
+
+	// Number of slots of the default table as a power of two
+	static const unsigned int DEFAULT_SIZE_LOG2 = 20;
+
+	// Constructs an empty table with 2^sizeLog2 slots
+	explicit TranspositionTable(unsigned int sizeLog2 = DEFAULT_SIZE_LOG2);
+
+	// Marks the start of a new search, entries from older searches are replaced first
+	void NewSearch();
+
+	// Removes all entries
+	void Clear();
+
+	// Returns true if an entry for the key was found
+	bool Probe(std::uint64_t key, TranspositionEntry& entryOut) const;
+
+	// Stores the entry unless the slot holds a deeper entry of the current search
+	void Store(std::uint64_t key, const TranspositionEntry& entry);
+
+private:
+
+	struct Slot
+	{
+		std::atomic<std::uint64_t> key;
+		std::atomic<std::uint64_t> data;
+	};
+
+	std::unique_ptr<Slot[]> m_slots;
+	std::uint64_t m_mask;
+	unsigned int m_generation;
+};
+
+#endif // _TRANSPOSITIONTABLE_H_
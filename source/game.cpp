@@ -45,6 +45,19 @@ using std::stringstream;
 using std::string;
 using std::ofstream;
 
+// Receives the next message from the server into the buffer of the connection and parses it in place
+static sexp_t* receiveExpression(Connection* c)
+{
+  char* message = rec_string_buffered(c->socket, &c->receiveBuffer);
+  if(message == NULL)
+  {
+    // the connection is broken, there's no point in going on
+    exit(1);
+  }
+
+  return extract_sexpr_in_place(message, c->receiveBuffer.length);
+}
+
 DLLEXPORT Connection* createConnection()
 {
   Connection* c = new Connection;
@@ -63,6 +76,8 @@ DLLEXPORT Connection* createConnection()
   c->PieceCount = 0;
   c->Players = NULL;
   c->PlayerCount = 0;
+  init_message_buffer(&c->receiveBuffer);
+  init_message_buffer(&c->sendBuffer);
   return c;
 }
 
@@ -93,6 +108,8 @@ DLLEXPORT void destroyConnection(Connection* c)
     }
     delete[] c->Players;
   }
+  free_message_buffer(&c->receiveBuffer);
+  free_message_buffer(&c->sendBuffer);
   delete c;
 }
 
@@ -114,9 +131,7 @@ DLLEXPORT int serverLogin(Connection* c, const char* username, const char* passw
 
   sexp_t* expression, *message;
 
-  char* reply = rec_string(c->socket);
-  expression = extract_sexpr(reply);
-  delete[] reply;
+  expression = receiveExpression(c);
 
   message = expression->list;
   if(message->val == NULL || strcmp(message->val, "login-accepted") != 0)
@@ -135,9 +150,7 @@ DLLEXPORT int createGame(Connection* c)
 
   send_string(c->socket, "(create-game)");
 
-  char* reply = rec_string(c->socket);
-  expression = extract_sexpr(reply);
-  delete[] reply;
+  expression = receiveExpression(c);
 
   number = expression->list->next;
   c->gameNumber = atoi(number->val);
@@ -160,9 +173,7 @@ DLLEXPORT int joinGame(Connection* c, int gameNum, const char* playerType)
   expr << "(join-game " << c->gameNumber << " "<< playerType << ")";
   send_string(c->socket, expr.str().c_str());
 
-  char* reply = rec_string(c->socket);
-  expression = extract_sexpr(reply);
-  delete[] reply;
+  expression = receiveExpression(c);
 
   if(strcmp(expression->list->val, "join-accepted") == 0)
   {
@@ -189,14 +200,14 @@ DLLEXPORT int joinGame(Connection* c, int gameNum, const char* playerType)
 DLLEXPORT void endTurn(Connection* c)
 {
   LOCK( &c->mutex );
-  send_string(c->socket, "(end-turn)");
+  flush_strings(c->socket, &c->sendBuffer, "(end-turn)");
   UNLOCK( &c->mutex );
 }
 
 DLLEXPORT void getStatus(Connection* c)
 {
   LOCK( &c->mutex );
-  send_string(c->socket, "(game-status)");
+  flush_strings(c->socket, &c->sendBuffer, "(game-status)");
   UNLOCK( &c->mutex );
 }
 
@@ -210,8 +221,9 @@ DLLEXPORT int pieceMove(_Piece* object, int file, int rank, int type)
        << " " << rank
        << " " << type
        << ")";
+  // the server only acts on the move at the end of the turn, so it is sent in the same write
   LOCK( &object->_c->mutex);
-  send_string(object->_c->socket, expr.str().c_str());
+  queue_string(&object->_c->sendBuffer, expr.str().c_str());
   UNLOCK( &object->_c->mutex);
   return 1;
 }
@@ -285,9 +297,7 @@ DLLEXPORT int networkLoop(Connection* c)
   {
     sexp_t* base, *expression, *sub;
 
-    char* message = rec_string(c->socket);
-    base = extract_sexpr(message);
-    delete[] message;
+    base = receiveExpression(c);
     expression = base->list;
     if(expression->val != NULL && strcmp(expression->val, "game-winner") == 0)
     {
@@ -42,6 +42,12 @@ struct Connection
   int PieceCount;
   _Player* Players;
   int PlayerCount;
+
+  // Messages from the server are received into this buffer and parsed in place
+  MessageBuffer receiveBuffer;
+
+  // Moves are queued in this buffer and sent together with the end of the turn
+  MessageBuffer sendBuffer;
 };
 
 #ifdef __cplusplus
@@ -12,7 +12,9 @@
 #pragma comment(lib, "Ws2_32.lib")
 #else
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <netdb.h>
 #include <arpa/inet.h>
 #define SOCKET_ERROR -1
@@ -76,10 +78,57 @@ DLLEXPORT int open_server_connection(const char* host, const char* port)
 #endif
         return -1;
     }
+
+    // every message is written with a single call, so there is nothing for Nagle's algorithm to merge
+    int nodelay = 1;
+    setsockopt(sock_server, IPPROTO_TCP, TCP_NODELAY, (const char*)&nodelay, sizeof(nodelay));
+
     return sock_server;
 }
 
 
+#ifdef _WIN32
+struct iovec
+{
+    void* iov_base;
+    size_t iov_len;
+};
+#endif
+
+// Sends every byte of the segments with as few calls as possible
+// Returns 0 on success, -1 if the connection is broken
+static int send_segments(int socket, struct iovec* segments, int count)
+{
+    while(count > 0)
+    {
+#ifdef _WIN32
+        int numbytes = send(socket, (const char*)segments->iov_base, segments->iov_len, 0);
+#else
+        int numbytes = writev(socket, segments, count);
+#endif
+        if(numbytes == SOCKET_ERROR)
+        {
+            return -1;
+        }
+
+        // skip the segments which were sent completely, then continue from the rest of the first one which was not
+        while(count > 0 && numbytes >= (int)segments->iov_len)
+        {
+            numbytes -= segments->iov_len;
+            segments++;
+            count--;
+        }
+
+        if(count > 0)
+        {
+            segments->iov_base = (char*)segments->iov_base + numbytes;
+            segments->iov_len -= numbytes;
+        }
+    }
+
+    return 0;
+}
+
 DLLEXPORT int send_string(int socket, const char* payload) {
 
 #ifdef SHOW_NETWORK
@@ -88,57 +137,23 @@ DLLEXPORT int send_string(int socket, const char* payload) {
 
     // this function only supports the fake 'no compression' scheme
 
-    char buffer[GLOBAL_BUFFER_SIZE];
-    int numbytes = strlen(payload)+1;
-    char * cstr = new char[numbytes]; //payload + \0
-    
-    memset(cstr, 0, numbytes);
-    strcat(cstr, payload);
-    
-    int offset = 0;
-
-    // add our packet header
-    int msg_len = numbytes-1;
-
+    int msg_len = strlen(payload);
     int n_msg_len = htonl(msg_len);
 
-    // first, send the payload size (4 bytes)
-   int val = send(socket, (char*)&n_msg_len, 4, 0);
-    if( val != 4)
+    // the payload size (4 bytes) and the payload are sent together, straight from where they are
+    struct iovec segments[2];
+    segments[0].iov_base = &n_msg_len;
+    segments[0].iov_len = 4;
+    segments[1].iov_base = (void*)payload;
+    segments[1].iov_len = msg_len;
+
+    if(send_segments(socket, segments, 2) != 0)
     {
-        cerr << "Connection broken." << endl;
-        cerr << "Sent: " << val << endl;
-        delete[] cstr;
+        cerr << "Error sending data to  server!" << endl;
         return -1;
     }
 
-    // now, keep sending chunks of the payload
-    // until we send the whole thing
-    
-
-    while(offset < msg_len)
-    {
-        // we can't copy GLOBAL_BUFFER_SIZE bytes each time,
-        // because that might push us past the end of cstr.
-        // figure out which is smaller, GLOBAL_BUFFER_SIZE
-        // or (payload.length() - offset)
-        int bytes_to_copy = min(GLOBAL_BUFFER_SIZE, msg_len - offset );
-        memcpy((void*)&buffer, (void*)(cstr+offset), bytes_to_copy);
-
-        if((numbytes = send(socket, buffer, bytes_to_copy, 0)) == -1)
-        {
-            cerr << "Error sending data to  server!" << endl;
-            delete[] cstr;
-            return -1;
-        }
-
-        // update the offset to copy from
-        offset += numbytes;
-    }
-    
-    delete[] cstr;
     return 0;
-
 }
 
 
@@ -203,6 +218,154 @@ DLLEXPORT char* rec_string(int socket)
     return ret;
 }
 
+DLLEXPORT void init_message_buffer(MessageBuffer* buffer)
+{
+    buffer->data = NULL;
+    buffer->capacity = 0;
+    buffer->length = 0;
+}
+
+DLLEXPORT void free_message_buffer(MessageBuffer* buffer)
+{
+    delete[] buffer->data;
+    init_message_buffer(buffer);
+}
+
+// Grows the buffer to hold at least capacity bytes, keeping its contents
+static void reserve_message_buffer(MessageBuffer* buffer, int capacity)
+{
+    if(buffer->capacity >= capacity)
+    {
+        return;
+    }
+
+    capacity = max(capacity, buffer->capacity * 2);
+
+    char* data = new char[capacity];
+    if(buffer->length > 0)
+    {
+        memcpy(data, buffer->data, buffer->length);
+    }
+
+    delete[] buffer->data;
+    buffer->data = data;
+    buffer->capacity = capacity;
+}
+
+DLLEXPORT void queue_string(MessageBuffer* buffer, const char* payload)
+{
+#ifdef SHOW_NETWORK
+    cout << "C: " << payload << endl;
+#endif
+
+    int msg_len = strlen(payload);
+    int n_msg_len = htonl(msg_len);
+
+    reserve_message_buffer(buffer, buffer->length + 4 + msg_len);
+
+    memcpy(buffer->data + buffer->length, &n_msg_len, 4);
+    memcpy(buffer->data + buffer->length + 4, payload, msg_len);
+    buffer->length += 4 + msg_len;
+}
+
+DLLEXPORT int flush_strings(int socket, MessageBuffer* buffer, const char* payload)
+{
+#ifdef SHOW_NETWORK
+    cout << "C: " << payload << endl;
+#endif
+
+    int msg_len = strlen(payload);
+    int n_msg_len = htonl(msg_len);
+
+    struct iovec segments[3];
+    segments[0].iov_base = buffer->data;
+    segments[0].iov_len = buffer->length;
+    segments[1].iov_base = &n_msg_len;
+    segments[1].iov_len = 4;
+    segments[2].iov_base = (void*)payload;
+    segments[2].iov_len = msg_len;
+
+    // the queued messages are dropped even if sending fails, the connection is broken then
+    int skipped = (buffer->length > 0) ? 0 : 1;
+    buffer->length = 0;
+
+    if(send_segments(socket, segments + skipped, 3 - skipped) != 0)
+    {
+        cerr << "Error sending data to  server!" << endl;
+        return -1;
+    }
+
+    return 0;
+}
+
+// Reads exactly size bytes, MSG_WAITALL lets a single recv fill the whole range
+// Returns false if the connection is broken
+static bool rec_all(int socket, char* buffer, int size)
+{
+    int received = 0;
+
+    while(received < size)
+    {
+        int numbytes = recv(socket, buffer + received, size - received, MSG_WAITALL);
+
+        if(numbytes == 0)
+        {
+            cerr << "Disconnected from server!" << endl;
+            // we've been disconnected, there's no point in going on
+            exit(0);
+        }
+
+        if(numbytes == SOCKET_ERROR)
+        {
+            return false;
+        }
+
+        // a signal can interrupt the wait after part of the data arrived
+        received += numbytes;
+    }
+
+    return true;
+}
+
+DLLEXPORT char* rec_string_buffered(int socket, MessageBuffer* buffer)
+{
+    int msg_len = 0;
+
+    // first, receive the payload size (4 bytes)
+    if(!rec_all(socket, (char*)&msg_len, 4))
+    {
+        cerr << "Error reading data from server!" << endl;
+        return NULL;
+    }
+
+    msg_len = ntohl(msg_len);
+    if(msg_len < 0)
+    {
+        cerr << "Invalid message length from server!" << endl;
+        return NULL;
+    }
+
+    // the parser scans the payload in place, which needs two NUL bytes after it
+    buffer->length = 0;
+    reserve_message_buffer(buffer, msg_len + 2);
+
+    if(!rec_all(socket, buffer->data, msg_len))
+    {
+        cerr << "Error reading data from server!" << endl;
+        return NULL;
+    }
+
+    buffer->data[msg_len] = 0;
+    buffer->data[msg_len + 1] = 0;
+    buffer->length = msg_len;
+
+#ifdef SHOW_NETWORK
+    cout << "S: " << buffer->data << endl;
+#endif
+
+    return buffer->data;
+}
+
 /*                                      sexpr functions                                       */
 
 DLLEXPORT char* escape_string(const char* string)
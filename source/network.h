@@ -19,6 +19,29 @@ extern "C"
   DLLEXPORT int open_server_connection(const char* host, const char* port);
   DLLEXPORT int send_string(int socket, const char* payload);
   DLLEXPORT char* rec_string(int socket);
+
+  // Buffer that messages are received into or queued in before sending,
+  // it grows to fit the largest message and is reused for the next one
+  struct MessageBuffer
+  {
+    char* data;
+    int capacity;
+    int length;
+  };
+
+  DLLEXPORT void init_message_buffer(struct MessageBuffer* buffer);
+  DLLEXPORT void free_message_buffer(struct MessageBuffer* buffer);
+
+  // Appends the payload with its length header to the buffer without sending it
+  DLLEXPORT void queue_string(struct MessageBuffer* buffer, const char* payload);
+
+  // Sends the queued messages followed by the payload with a single writev and empties the buffer
+  DLLEXPORT int flush_strings(int socket, struct MessageBuffer* buffer, const char* payload);
+
+  // Receives a message directly into the buffer and returns its payload, or NULL if the connection is broken.
+  // The payload is followed by two NUL bytes so that extract_sexpr_in_place can parse it without copying,
+  // it stays valid until the next message is received into the buffer
+  DLLEXPORT char* rec_string_buffered(int socket, struct MessageBuffer* buffer);
   
   DLLEXPORT char* escape_string(const char* string);
 #ifdef __cplusplus
@@ -17,6 +17,15 @@ Sexp* extract_sexpr(const char* in)
   return ret;
 }
 
+Sexp* extract_sexpr_in_place(char* buffer, int length)
+{
+  Sexp* ret;
+  yy_scan_buffer(buffer, length + 2);
+  ret = parse();
+  yypop_buffer_state();
+  return ret;
+}
+
 int sexp_list_length(Sexp* s)
 {
   int length = 0;
@@ -9,6 +9,9 @@ void destroy_sexp(Sexp*);
 
 Sexp* extract_sexpr(const char*);
 
+// Parses the buffer without copying it, the buffer is modified while scanning and must end with two NUL bytes after length
+Sexp* extract_sexpr_in_place(char* buffer, int length);
+
 int sexp_list_length(Sexp*);
 
 #endif
\ No newline at end of file
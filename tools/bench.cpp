@@ -0,0 +1,11 @@
+#include "Bench.h"
+#include <cstdlib>
+#include <iostream>
+
+// bench [depth] searches the bench positions and prints their node count signature and speed
+int main(int argc, char** argv)
+{
+	unsigned int depth = (argc > 1) ? std::atoi(argv[1]) : DEFAULT_BENCH_DEPTH;
+
+	return RunBench(depth, std::cout) ? 0 : 1;
+}
@@ -0,0 +1,161 @@
+#include "Board.h"
+#include "Heuristics.h"
+#include "Search.h"
+#include "TranspositionTable.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+// Every allocation of the process is counted, so that allocations per operation can be reported
+static std::atomic<std::uint64_t> s_allocations(0);
+
+void* operator new(std::size_t size)
+{
+	s_allocations.fetch_add(1, std::memory_order_relaxed);
+
+	void* pMemory = std::malloc((size > 0) ? size : 1);
+	if(pMemory == nullptr)
+		throw std::bad_alloc();
+
+	return pMemory;
+}
+
+void* operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* pMemory) noexcept
+{
+	std::free(pMemory);
+}
+
+void operator delete[](void* pMemory) noexcept
+{
+	std::free(pMemory);
+}
+
+void operator delete(void* pMemory, std::size_t) noexcept
+{
+	std::free(pMemory);
+}
+
+void operator delete[](void* pMemory, std::size_t) noexcept
+{
+	std::free(pMemory);
+}
+
+// Each benchmark is repeated until it ran for at least this many nanoseconds
+static const std::uint64_t MIN_BENCHMARK_TIME = 200000000;
+
+// Results are accumulated here so that the compiler cannot remove the benchmarked calls
+static volatile std::uint64_t s_sink = 0;
+
+struct BenchPosition
+{
+	const char* name;
+	const char* fen;
+};
+
+static const BenchPosition POSITIONS[] =
+{
+	{"opening", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"},
+	{"middlegame", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 10"},
+	{"endgame", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 11"},
+};
+
+// Runs the operation with doubling iteration counts until the run is long enough, then prints its time and allocations per operation
+template<class T>
+void RunBenchmark(const char* name, const char* positionName, T operation)
+{
+	std::uint64_t iterations = 1;
+	std::uint64_t time = 0;
+	std::uint64_t allocations = 0;
+
+	while(true)
+	{
+		std::uint64_t allocationsStart = s_allocations.load(std::memory_order_relaxed);
+		auto start = std::chrono::steady_clock::now();
+
+		for(std::uint64_t i = 0; i < iterations; ++i)
+		{
+			operation(i);
+		}
+
+		time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+		allocations = s_allocations.load(std::memory_order_relaxed) - allocationsStart;
+
+		if(time >= MIN_BENCHMARK_TIME)
+			break;
+
+		iterations *= 2;
+	}
+
+	std::cout << std::left << std::setw(20) << name << std::setw(12) << positionName << std::right
+			  << std::setw(12) << iterations << std::fixed << std::setprecision(1)
+			  << std::setw(12) << double(time) / iterations << std::setprecision(2)
+			  << std::setw(12) << double(allocations) / iterations << std::endl;
+}
+
+// microbench times the hot functions of the board and the search on an opening, a middlegame and an endgame position
+int main()
+{
+	std::cout << std::left << std::setw(20) << "Benchmark" << std::setw(12) << "Position" << std::right
+			  << std::setw(12) << "Iterations" << std::setw(12) << "ns/op" << std::setw(12) << "allocs/op" << std::endl;
+
+	TranspositionTable transpositionTable(10);
+	std::atomic_bool bStop(false);
+
+	for(const BenchPosition& position : POSITIONS)
+	{
+		Board board;
+		int playerID = 0;
+		if(!board.LoadFEN(position.fen, playerID))
+		{
+			std::cerr << "Invalid FEN: " << position.fen << std::endl;
+			return 1;
+		}
+
+		const std::vector<BoardMove> moves = board.GetMoves(playerID);
+
+		RunBenchmark("GetMoves", position.name, [&](std::uint64_t)
+		{
+			s_sink += board.GetMoves(playerID).size();
+		});
+
+		// One operation applies and undoes one of the moves, cycling through all of them
+		RunBenchmark("ApplyMove", position.name, [&](std::uint64_t i)
+		{
+			ApplyMove apply(moves[i % moves.size()], &board);
+		});
+
+		RunBenchmark("IsInCheck", position.name, [&](std::uint64_t)
+		{
+			s_sink += board.IsInCheck(playerID);
+		});
+
+		RunBenchmark("GetWorth", position.name, [&](std::uint64_t)
+		{
+			s_sink += board.GetWorth(playerID, ChessHeuristic());
+		});
+
+		RunBenchmark("IsInStalemate", position.name, [&](std::uint64_t)
+		{
+			s_sink += board.IsInStalemate(playerID);
+		});
+
+		Search search(board, transpositionTable, bStop);
+		RunBenchmark("MoveOrdering", position.name, [&](std::uint64_t)
+		{
+			s_sink += search.MoveOrdering(playerID, moves).size();
+		});
+	}
+
+	return 0;
+}
@@ -0,0 +1,64 @@
+#include "Board.h"
+#include "Timer.h"
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+// Returns the number of move sequences of the depth from the position, the last ply is counted without making its moves
+static std::uint64_t Perft(Board& board, int playerID, unsigned int depth)
+{
+	if(depth == 0)
+		return 1;
+
+	if(depth == 1)
+		return board.CountLegalMoves(playerID);
+
+	std::uint64_t nodes = 0;
+	for(const BoardMove& move : board.GetMoves(playerID))
+	{
+		board.MakeMove(move);
+		nodes += Perft(board, !playerID, depth - 1);
+		board.UnmakeMove(move);
+	}
+
+	return nodes;
+}
+
+// perft [depth] [fen] counts the leaf nodes of the move generator, the nodes below each root move are printed to find where it goes wrong
+int main(int argc, char** argv)
+{
+	unsigned int depth = (argc > 1) ? std::atoi(argv[1]) : 4;
+	std::string fen = (argc > 2) ? argv[2] : "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+	Board board;
+	int playerID = 0;
+	if(!board.LoadFEN(fen, playerID))
+	{
+		std::cerr << "Invalid FEN: " << fen << std::endl;
+		return 1;
+	}
+
+	Timer timer;
+	timer.Start();
+
+	std::uint64_t nodes = 0;
+	for(const BoardMove& move : board.GetMoves(playerID))
+	{
+		board.MakeMove(move);
+		std::uint64_t moveNodes = (depth > 0) ? Perft(board, !playerID, depth - 1) : 0;
+		board.UnmakeMove(move);
+
+		// The move ends the line
+		std::cout << moveNodes << " " << move;
+		nodes += moveNodes;
+	}
+
+	std::uint64_t time = timer.GetTime();
+
+	std::cout << "Nodes: " << nodes << std::endl;
+	std::cout << "Time (ms): " << time / 1000000 << std::endl;
+	std::cout << "Nodes/second: " << ((time > 0) ? std::uint64_t(nodes * 1000000000.0 / time) : 0) << std::endl;
+
+	return 0;
+}
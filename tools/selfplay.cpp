@@ -0,0 +1,452 @@
+#include "Board.h"
+#include "Log.h"
+#include "Search.h"
+#include "SearchStats.h"
+#include "TimeManager.h"
+#include "TranspositionTable.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Time on the clock of each player at the start of a game, in seconds, the same as the game server
+static const float DEFAULT_CLOCK_TIME = 900.0f;
+
+// Games which have not ended after this many plies are adjudicated as draws
+static const unsigned int MAX_GAME_PLIES = 600;
+
+// Size of the transposition table of each player, smaller than the client's so that many games fit in memory
+static const unsigned int SELFPLAY_TT_SIZE_LOG2 = 18;
+
+// Hypotheses and error rates of the SPRT, H0 is that B is not stronger than A and H1 is that B is SPRT_ELO1 stronger
+static const double SPRT_ELO0 = 0.0;
+static const double SPRT_ELO1 = 5.0;
+static const double SPRT_ALPHA = 0.05;
+static const double SPRT_BETA = 0.05;
+
+// Balanced openings, each is played twice with the colors swapped
+static const char* const OPENINGS[] =
+{
+	"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+	"rnbqkbnr/pppp1ppp/8/4p3/4P3/8/PPPP1PPP/RNBQKBNR w KQkq - 0 2",
+	"rnbqkbnr/pp1ppppp/8/2p5/4P3/8/PPPP1PPP/RNBQKBNR w KQkq - 0 2",
+	"rnbqkbnr/ppp1pppp/8/3p4/3P4/8/PPP1PPPP/RNBQKBNR w KQkq - 0 2",
+	"rnbqkb1r/pppppppp/5n2/8/3P4/8/PPP1PPPP/RNBQKBNR w KQkq - 1 2",
+	"rnbqkbnr/pppp1ppp/4p3/8/4P3/8/PPPP1PPP/RNBQKBNR w KQkq - 0 2",
+	"rnbqkbnr/pp1ppppp/2p5/8/4P3/8/PPPP1PPP/RNBQKBNR w KQkq - 0 2",
+	"rnbqkbnr/pppppppp/8/8/2P5/8/PP1PPPPP/RNBQKBNR b KQkq - 0 1",
+	"r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3",
+	"rnbqkb1r/pppp1ppp/4pn2/8/2PP4/8/PP2PPPP/RNBQKBNR w KQkq - 0 3",
+};
+
+// Runtime parameters of an engine playing in the match
+struct EngineConfig
+{
+	std::string name;
+
+	// Deepest iteration of iterative deepening
+	unsigned int depth;
+
+	unsigned int transpositionTableSizeLog2;
+
+	// Switches and margins of the pruning, internal iterative deepening and easy moves
+	SearchOptions searchOptions;
+
+	// Scale of the time the engine aims to spend on each move
+	double timeScale;
+};
+
+enum class GameResult
+{
+	WinA,
+	Draw,
+	WinB,
+};
+
+// State of one side of a game, each side keeps its own table and history between its moves like the client does
+struct Player
+{
+	Player(const EngineConfig& c, unsigned int seed) : config(c), transpositionTable(c.transpositionTableSizeLog2),
+		history(), remainingTime(DEFAULT_CLOCK_TIME), movesPlayed(0), randEngine(seed)
+	{
+		timeManager.SetTimeScale(c.timeScale);
+	}
+
+	const EngineConfig& config;
+	TranspositionTable transpositionTable;
+	TimeManager timeManager;
+	Search::HistoryTable history;
+	float remainingTime;
+	unsigned int movesPlayed;
+	std::default_random_engine randEngine;
+};
+
+// Wins, draws and losses from the perspective of engine B
+struct MatchResults
+{
+	MatchResults() : wins(0), draws(0), losses(0)
+	{
+	}
+
+	unsigned int wins;
+	unsigned int draws;
+	unsigned int losses;
+};
+
+// Plays a game from the opening with simulated clocks, sets reasonOut to why the game ended
+static GameResult PlayGame(const EngineConfig& white, const EngineConfig& black, const char* opening, float clockTime,
+						   unsigned int seed, bool bWhiteIsA, std::string& reasonOut)
+{
+	Board board;
+	int playerIDToMove = 0;
+	if(!board.LoadFEN(opening, playerIDToMove))
+	{
+		reasonOut = "invalid opening";
+		return GameResult::Draw;
+	}
+
+	Player whitePlayer(white, seed);
+	Player blackPlayer(black, seed + 1);
+	whitePlayer.remainingTime = clockTime;
+	blackPlayer.remainingTime = clockTime;
+	Player* players[2] = { &whitePlayer, &blackPlayer };
+
+	std::atomic_bool bStop(false);
+
+	for(unsigned int ply = 0; ply < MAX_GAME_PLIES; ++ply)
+	{
+		Player& player = *players[playerIDToMove];
+		player.timeManager.Start(player.remainingTime, player.movesPlayed);
+
+		// Positions before the move count as positions of the game for the repetition rule
+		board.SetRoot();
+
+		BoardMove bestMove;
+		std::vector<BoardMove> moves = board.GetMoves(playerIDToMove);
+		if(moves.size() == 1)
+		{
+			bestMove = moves.front();
+		}
+		else
+		{
+			Search search(board, player.transpositionTable, player.timeManager, bStop, player.config.depth, player.randEngine());
+			search.SetHistory(player.history);
+			search.SetOptions(player.config.searchOptions);
+
+			player.transpositionTable.NewSearch();
+			search.MiniMax(playerIDToMove, false, bestMove, true);
+			player.history = search.GetHistory();
+		}
+
+		player.remainingTime -= player.timeManager.GetElapsedTime() / 1e9f;
+		++player.movesPlayed;
+
+		bool bMoverIsA = ((playerIDToMove == 0) == bWhiteIsA);
+		if(player.remainingTime <= 0.0f)
+		{
+			reasonOut = "time forfeit";
+			return bMoverIsA ? GameResult::WinB : GameResult::WinA;
+		}
+
+		board.MakeMove(bestMove);
+		playerIDToMove = !playerIDToMove;
+
+		if(board.IsInCheckmate(playerIDToMove))
+		{
+			reasonOut = "checkmate";
+			return bMoverIsA ? GameResult::WinA : GameResult::WinB;
+		}
+
+		if(board.IsInStalemate(playerIDToMove))
+		{
+			reasonOut = "draw";
+			return GameResult::Draw;
+		}
+	}
+
+	reasonOut = "move limit";
+	return GameResult::Draw;
+}
+
+// Reads a comma separated list of integers, returns false if any of them is not a number
+static bool ParseList(const std::string& value, std::vector<int>& valuesOut)
+{
+	std::istringstream stream(value);
+	std::string item;
+
+	valuesOut.clear();
+	while(std::getline(stream, item, ','))
+	{
+		char* pEnd = nullptr;
+		long number = std::strtol(item.c_str(), &pEnd, 10);
+		if(item.empty() || (*pEnd != '\0'))
+			return false;
+
+		valuesOut.push_back(int(number));
+	}
+
+	return !valuesOut.empty();
+}
+
+// Sets the option of the config to the value, margins are given for every remaining depth from 1 up.
+// Returns false if the option is unknown or the value is invalid
+static bool ParseOption(const std::string& name, const std::string& value, EngineConfig& config)
+{
+	SearchOptions& options = config.searchOptions;
+
+	if(name == "timescale")
+	{
+		config.timeScale = std::atof(value.c_str());
+		return (config.timeScale > 0.0);
+	}
+
+	std::vector<int> values;
+	if(!ParseList(value, values))
+		return false;
+
+	if(name == "depth")
+	{
+		config.depth = (values[0] > 0) ? values[0] : std::numeric_limits<unsigned int>::max();
+	}
+	else if(name == "tt")
+	{
+		config.transpositionTableSizeLog2 = values[0];
+	}
+	else if(name == "pruning")
+	{
+		options.bPruning = (values[0] != 0);
+	}
+	else if(name == "rfp")
+	{
+		options.reverseFutilityMargin = values[0];
+	}
+	else if(name == "futility")
+	{
+		if(values.size() != (options.futilityMargins.size() - 1))
+			return false;
+
+		std::copy(values.begin(), values.end(), options.futilityMargins.begin() + 1);
+	}
+	else if(name == "razor")
+	{
+		if(values.size() != (options.razorMargins.size() - 1))
+			return false;
+
+		std::copy(values.begin(), values.end(), options.razorMargins.begin() + 1);
+	}
+	else if(name == "iid")
+	{
+		options.bInternalIterativeDeepening = (values[0] != 0);
+	}
+	else if(name == "easymove")
+	{
+		options.bEasyMove = (values[0] != 0);
+	}
+	else
+	{
+		return false;
+	}
+
+	return true;
+}
+
+// Returns the Elo difference which is expected to score the fraction of the points
+static double ScoreToElo(double score)
+{
+	return -400.0 * std::log10(1.0 / score - 1.0);
+}
+
+// Returns the fraction of the points which is expected with the Elo difference
+static double EloToScore(double elo)
+{
+	return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0));
+}
+
+// Writes the score, the Elo difference of B over A with its 95% confidence interval, and the state of the SPRT
+static void WriteSummary(const EngineConfig& a, const EngineConfig& b, const MatchResults& results, std::ostream& stream)
+{
+	unsigned int games = results.wins + results.draws + results.losses;
+	if(games == 0)
+		return;
+
+	double score = (results.wins + 0.5 * results.draws) / games;
+	double winFraction = double(results.wins) / games;
+	double drawFraction = double(results.draws) / games;
+	double lossFraction = double(results.losses) / games;
+	double variance = winFraction * (1.0 - score) * (1.0 - score) + drawFraction * (0.5 - score) * (0.5 - score) + lossFraction * score * score;
+
+	stream << "===========================" << std::endl;
+	stream << b.name << " vs " << a.name << ": +" << results.wins << " =" << results.draws << " -" << results.losses
+		   << " (" << score * 100.0 << "%)" << std::endl;
+
+	// The Elo difference is infinite while one side has scored every point
+	if((score <= 0.0) || (score >= 1.0) || (variance <= 0.0))
+	{
+		stream << "Elo             : not enough decisive games" << std::endl;
+		return;
+	}
+
+	double error = 1.96 * std::sqrt(variance / games);
+	double lower = std::max(score - error, 1e-6);
+	double upper = std::min(score + error, 1.0 - 1e-6);
+	double elo = ScoreToElo(score);
+
+	stream << "Elo             : " << elo << " +/- " << (ScoreToElo(upper) - ScoreToElo(lower)) / 2.0 << std::endl;
+
+	// Log likelihood ratio of the two hypotheses, with the score of each game approximated by a normal distribution
+	double score0 = EloToScore(SPRT_ELO0);
+	double score1 = EloToScore(SPRT_ELO1);
+	double llr = games * (score1 - score0) * (2.0 * score - score0 - score1) / (2.0 * variance);
+	double lowerBound = std::log(SPRT_BETA / (1.0 - SPRT_ALPHA));
+	double upperBound = std::log((1.0 - SPRT_BETA) / SPRT_ALPHA);
+
+	stream << "SPRT            : elo0=" << SPRT_ELO0 << " elo1=" << SPRT_ELO1 << " alpha=" << SPRT_ALPHA << " beta=" << SPRT_BETA << std::endl;
+	stream << "LLR             : " << llr << " [" << lowerBound << ", " << upperBound << "] ";
+
+	if(llr >= upperBound)
+	{
+		stream << "H1 accepted" << std::endl;
+	}
+	else if(llr <= lowerBound)
+	{
+		stream << "H0 accepted" << std::endl;
+	}
+	else
+	{
+		stream << "inconclusive" << std::endl;
+	}
+}
+
+// selfplay [games] [threads] [seconds] [depthA] [depthB] [tableSizeLog2A] [tableSizeLog2B] [[a.|b.]option=value ...]
+// plays a match between two configurations of the engine, a depth of 0 is unlimited.
+// The options are depth, tt, pruning, rfp, futility, razor, iid, easymove and timescale, without a prefix an option is set for both engines.
+// Each opening is played twice with the colors swapped, and the results are from the perspective of B
+int main(int argc, char** argv)
+{
+	// The positional arguments are the ones without an '=', the options may be given between them
+	std::vector<const char*> args;
+	std::vector<std::string> options;
+	for(int i = 1; i < argc; ++i)
+	{
+		if(std::strchr(argv[i], '=') == nullptr)
+		{
+			args.push_back(argv[i]);
+		}
+		else
+		{
+			options.push_back(argv[i]);
+		}
+	}
+
+	unsigned int gameCount = (args.size() > 0) ? std::atoi(args[0]) : 2 * (sizeof(OPENINGS) / sizeof(OPENINGS[0]));
+	unsigned int threadCount = (args.size() > 1) ? std::atoi(args[1]) : std::max(std::thread::hardware_concurrency(), 1u);
+	float clockTime = (args.size() > 2) ? float(std::atof(args[2])) : DEFAULT_CLOCK_TIME;
+
+	EngineConfig configs[2];
+	for(unsigned int i = 0; i < 2; ++i)
+	{
+		unsigned int depth = (args.size() > 3 + i) ? std::atoi(args[3 + i]) : 0;
+
+		configs[i].name = (i == 0) ? "A" : "B";
+		configs[i].depth = (depth > 0) ? depth : std::numeric_limits<unsigned int>::max();
+		configs[i].transpositionTableSizeLog2 = (args.size() > 5 + i) ? std::atoi(args[5 + i]) : SELFPLAY_TT_SIZE_LOG2;
+		configs[i].timeScale = 1.0;
+	}
+
+	bool bValidOptions = true;
+	for(const std::string& option : options)
+	{
+		std::string name = option.substr(0, option.find('='));
+		std::string value = option.substr(option.find('=') + 1);
+
+		bool bOnlyA = (name.compare(0, 2, "a.") == 0);
+		bool bOnlyB = (name.compare(0, 2, "b.") == 0);
+		if(bOnlyA || bOnlyB)
+		{
+			name = name.substr(2);
+		}
+
+		for(unsigned int i = 0; i < 2; ++i)
+		{
+			if((i == 0) ? !bOnlyB : !bOnlyA)
+			{
+				bValidOptions = ParseOption(name, value, configs[i]) && bValidOptions;
+			}
+		}
+	}
+
+	if((gameCount == 0) || (threadCount == 0) || (clockTime <= 0.0f) || !bValidOptions)
+	{
+		std::cerr << "usage: selfplay [games] [threads] [seconds] [depthA] [depthB] [tableSizeLog2A] [tableSizeLog2B] [[a.|b.]option=value ...]" << std::endl;
+		std::cerr << "options: depth=<plies> tt=<log2 entries> pruning=<0|1> rfp=<margin> futility=<margin,margin> "
+					 "razor=<margin,margin,margin> iid=<0|1> easymove=<0|1> timescale=<factor>" << std::endl;
+		return 1;
+	}
+
+	// The searches of the games would interleave their logs, only the results are written
+	SetLogStream(nullptr);
+	SetSearchStatsEnabled(false);
+
+	std::atomic<unsigned int> nextGame(0);
+	std::mutex resultsMutex;
+	MatchResults results;
+
+	std::vector<std::thread> threads;
+	for(unsigned int i = 0; i < threadCount; ++i)
+	{
+		threads.push_back(std::thread([&]()
+		{
+			unsigned int game;
+			while((game = nextGame.fetch_add(1)) < gameCount)
+			{
+				const char* opening = OPENINGS[(game / 2) % (sizeof(OPENINGS) / sizeof(OPENINGS[0]))];
+				bool bWhiteIsA = (game % 2) == 0;
+				const EngineConfig& white = bWhiteIsA ? configs[0] : configs[1];
+				const EngineConfig& black = bWhiteIsA ? configs[1] : configs[0];
+
+				std::string reason;
+				GameResult result = PlayGame(white, black, opening, clockTime, 2 * game, bWhiteIsA, reason);
+
+				resultsMutex.lock();
+
+				if(result == GameResult::WinB)
+				{
+					++results.wins;
+				}
+				else if(result == GameResult::Draw)
+				{
+					++results.draws;
+				}
+				else
+				{
+					++results.losses;
+				}
+
+				const char* score = (result == GameResult::Draw) ? "1/2-1/2" : (((result == GameResult::WinA) == bWhiteIsA) ? "1-0" : "0-1");
+				std::cout << "Game " << (game + 1) << "/" << gameCount << ": " << white.name << " vs " << black.name << " "
+						  << score << " (" << reason << "), +" << results.wins << " =" << results.draws << " -" << results.losses << std::endl;
+
+				resultsMutex.unlock();
+			}
+		}));
+	}
+
+	for(std::thread& thread : threads)
+	{
+		thread.join();
+	}
+
+	WriteSummary(configs[0], configs[1], results, std::cout);
+
+	return 0;
+}
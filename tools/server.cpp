@@ -0,0 +1,894 @@
+#include "Board.h"
+#include "sfcompat.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Port of the game server which the client connects to
+static const char* const DEFAULT_PORT = "19000";
+
+// Time on the clock of each player at the start of a game, in seconds
+static const float DEFAULT_CLOCK_TIME = 900.0f;
+
+// Messages longer than this are treated as a broken connection
+static const std::uint32_t MAX_MESSAGE_SIZE = 1 << 24;
+
+// Most bytes read from a client each time poll reports its socket as readable
+static const std::size_t RECEIVE_CHUNK_SIZE = 65536;
+
+// Identifier sent as the winner of a game which ended in a draw
+static const int DRAW_PLAYER_ID = 2;
+
+static const char* const START_POSITION = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+// A connected client
+struct Client
+{
+	int socket;
+
+	// Name sent with the login, empty until the client has logged in
+	std::string name;
+
+	// Game the client plays in and its player in the game, the game number is 0 if it has not created or joined a game
+	int gameNumber;
+	int playerID;
+
+	// Bytes received from the client which do not form a complete message yet
+	std::string receiveBuffer;
+};
+
+// A move played in a game
+struct PlayedMove
+{
+	int id;
+	BoardMove move;
+};
+
+struct Game
+{
+	Game() : number(0), playerIDToMove(0), turnNumber(0), bStarted(false), bOver(false), bMoved(false)
+	{
+		sockets[0] = sockets[1] = -1;
+		time[0] = time[1] = 0.0f;
+	}
+
+	int number;
+
+	// Sockets of the players, -1 once a player has left the game
+	int sockets[2];
+	std::string names[2];
+
+	// Time left on the clock of each player in seconds, the time of the player to move is charged when the turn ends
+	float time[2];
+
+	Board board;
+
+	// Moves played in the game, the first move first
+	std::vector<PlayedMove> moves;
+
+	int playerIDToMove;
+	int turnNumber;
+	std::chrono::steady_clock::time_point turnStart;
+
+	bool bStarted;
+	bool bOver;
+
+	// True once the player to move has made the move of the turn
+	bool bMoved;
+
+	// Contents of the .gamelog file, one s-expression per line
+	std::ostringstream log;
+};
+
+// Appends the bytes which have arrived on the socket to the buffer without waiting for more, returns false if the connection was closed or broken
+static bool ReceiveAvailable(int socket, std::string& buffer)
+{
+	char chunk[RECEIVE_CHUNK_SIZE];
+	ssize_t count = recv(socket, chunk, sizeof(chunk), MSG_DONTWAIT);
+	if(count > 0)
+	{
+		buffer.append(chunk, count);
+		return true;
+	}
+
+	return (count < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR));
+}
+
+// Sets lengthOut to the length of the first message in the buffer, which is framed by its length as a 4 byte integer in network byte order.
+// Returns false if the buffer does not hold the whole length yet
+static bool GetMessageLength(const std::string& buffer, std::uint32_t& lengthOut)
+{
+	if(buffer.size() < sizeof(lengthOut))
+		return false;
+
+	std::memcpy(&lengthOut, buffer.data(), sizeof(lengthOut));
+	lengthOut = ntohl(lengthOut);
+	return true;
+}
+
+// Sends the payload framed by its length, the header and the payload are sent with a single write
+static bool SendMessage(int socket, const std::string& payload)
+{
+	std::uint32_t length = htonl(payload.size());
+	std::string buffer(reinterpret_cast<const char*>(&length), sizeof(length));
+	buffer += payload;
+
+	std::size_t sent = 0;
+	while(sent < buffer.size())
+	{
+		ssize_t count = send(socket, buffer.data() + sent, buffer.size() - sent, MSG_NOSIGNAL);
+		if(count <= 0)
+			return false;
+
+		sent += count;
+	}
+
+	return true;
+}
+
+// Returns the text as an s-expression string, with quotes and backslashes escaped
+static std::string Quote(const std::string& text)
+{
+	std::string result = "\"";
+	for(char c : text)
+	{
+		if((c == '\\') || (c == '"'))
+		{
+			result += '\\';
+		}
+
+		result += c;
+	}
+
+	return result + "\"";
+}
+
+// Returns the value of the argument at index after the name of the command, or nullptr if there is no such value
+static const char* GetArgument(const Sexp* pCommand, unsigned int index)
+{
+	const Sexp* pArgument = pCommand->next;
+	while((pArgument != nullptr) && (index > 0))
+	{
+		pArgument = pArgument->next;
+		--index;
+	}
+
+	return (pArgument != nullptr) ? pArgument->val : nullptr;
+}
+
+// Sets valueOut to the integer argument at index, returns false if the argument is missing
+static bool GetIntArgument(const Sexp* pCommand, unsigned int index, int& valueOut)
+{
+	const char* pValue = GetArgument(pCommand, index);
+	if(pValue == nullptr)
+		return false;
+
+	valueOut = std::atoi(pValue);
+	return true;
+}
+
+// Plays games between clients over the s-expression protocol of the game server.
+// All clients are served by one thread polling their sockets, the s-expression parser can only be used by one thread at a time
+class Server
+{
+public:
+
+	// Each player starts with clockTime seconds, the server stops after maxGames games or runs until it is killed if maxGames is 0
+	Server(float clockTime, unsigned int maxGames);
+	~Server();
+
+	// Listens for clients on the loopback interface, returns false if the port cannot be bound
+	bool Listen(const char* port);
+
+	// Serves the clients until the number of games has been played and every client has disconnected
+	void Run();
+
+private:
+
+	void Accept();
+
+	// Receives what the client has sent without blocking and handles every complete message, the rest is kept until more of it arrives.
+	// Returns false if the client disconnected or sent a message longer than MAX_MESSAGE_SIZE
+	bool ReceiveMessages(Client& client);
+
+	void HandleMessage(Client& client, const std::string& message);
+
+	void Login(Client& client, const Sexp* pCommand);
+	void CreateGame(Client& client);
+	void JoinGame(Client& client, const Sexp* pCommand);
+	void StartGame(Client& client);
+	void MovePiece(Client& client, const Sexp* pCommand);
+	void EndTurn(Client& client);
+	void SendStatus(Client& client);
+	void SendLog(Client& client, const Sexp* pCommand);
+
+	// Ends the game of a client which disconnected and forgets the client
+	void Disconnect(int socket);
+
+	// Starts the clock of the player to move and sends them the status of the game
+	void StartTurn(Game& game);
+
+	// Writes the status of the game as seen by the player
+	std::string GetStatus(const Game& game, int playerID) const;
+
+	// Ends the game, writes its .gamelog file and sends the winner to both players
+	void EndGame(Game& game, int winnerID, const std::string& reason);
+
+	// Ends every game whose player to move has run out of time, returns the milliseconds until the next clock runs out or -1 if no clock is running
+	int CheckClocks();
+
+	// Returns the game of the client if the client is the player to move, otherwise denies the command and returns nullptr
+	Game* GetTurnGame(Client& client, const char* command);
+
+	void Deny(const Client& client, const char* command, const std::string& reason);
+
+	// Returns the seconds the player to move has used in the current turn
+	static float GetTurnTime(const Game& game);
+
+private:
+
+	int m_listenSocket;
+	float m_clockTime;
+	unsigned int m_maxGames;
+	unsigned int m_completedGames;
+	int m_nextGameNumber;
+
+	std::map<int, Client> m_clients;
+	std::map<int, std::unique_ptr<Game>> m_games;
+};
+
+Server::Server(float clockTime, unsigned int maxGames) : m_listenSocket(-1), m_clockTime(clockTime), m_maxGames(maxGames),
+	m_completedGames(0), m_nextGameNumber(1)
+{
+}
+
+Server::~Server()
+{
+	for(auto& iter : m_clients)
+	{
+		close(iter.first);
+	}
+
+	if(m_listenSocket != -1)
+	{
+		close(m_listenSocket);
+	}
+}
+
+bool Server::Listen(const char* port)
+{
+	m_listenSocket = socket(AF_INET, SOCK_STREAM, 0);
+	if(m_listenSocket == -1)
+		return false;
+
+	int reuse = 1;
+	setsockopt(m_listenSocket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+	sockaddr_in address = {};
+	address.sin_family = AF_INET;
+	address.sin_port = htons(std::atoi(port));
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	if((bind(m_listenSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == -1) || (listen(m_listenSocket, 16) == -1))
+		return false;
+
+	std::cout << "Listening on 127.0.0.1:" << port << std::endl;
+	return true;
+}
+
+void Server::Run()
+{
+	std::vector<pollfd> descriptors;
+
+	while((m_maxGames == 0) || (m_completedGames < m_maxGames) || !m_clients.empty())
+	{
+		int timeout = CheckClocks();
+
+		descriptors.clear();
+
+		// New clients are not accepted once all of the games have been played
+		if((m_maxGames == 0) || (m_completedGames < m_maxGames))
+		{
+			descriptors.push_back({m_listenSocket, POLLIN, 0});
+		}
+
+		for(auto& iter : m_clients)
+		{
+			descriptors.push_back({iter.first, POLLIN, 0});
+		}
+
+		if(poll(descriptors.data(), descriptors.size(), timeout) < 0)
+			continue;
+
+		for(const pollfd& descriptor : descriptors)
+		{
+			if(descriptor.revents == 0)
+				continue;
+
+			if(descriptor.fd == m_listenSocket)
+			{
+				Accept();
+				continue;
+			}
+
+			// The client may have been removed while handling the messages before it
+			auto iter = m_clients.find(descriptor.fd);
+			if((iter != m_clients.end()) && !ReceiveMessages(iter->second))
+			{
+				Disconnect(descriptor.fd);
+			}
+		}
+	}
+}
+
+void Server::Accept()
+{
+	int socket = accept(m_listenSocket, nullptr, nullptr);
+	if(socket == -1)
+		return;
+
+	// Each message is sent with a single write, so the reply to a turn should not wait for the acknowledgement of the previous one
+	int noDelay = 1;
+	setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+	Client client = {socket, "", 0, 0, ""};
+	m_clients[socket] = client;
+}
+
+bool Server::ReceiveMessages(Client& client)
+{
+	if(!ReceiveAvailable(client.socket, client.receiveBuffer))
+		return false;
+
+	std::uint32_t length = 0;
+	while(GetMessageLength(client.receiveBuffer, length))
+	{
+		if(length > MAX_MESSAGE_SIZE)
+			return false;
+
+		if(client.receiveBuffer.size() < (sizeof(length) + length))
+			break;
+
+		std::string message = client.receiveBuffer.substr(sizeof(length), length);
+		client.receiveBuffer.erase(0, sizeof(length) + length);
+
+		HandleMessage(client, message);
+	}
+
+	return true;
+}
+
+void Server::HandleMessage(Client& client, const std::string& message)
+{
+	Sexp* pBase = extract_sexpr(message.c_str());
+	const Sexp* pCommand = (pBase != nullptr) ? pBase->list : nullptr;
+
+	if((pCommand == nullptr) || (pCommand->val == nullptr))
+	{
+		Deny(client, "command", "Malformed message");
+	}
+	else
+	{
+		std::string command = pCommand->val;
+
+		if(command == "login")
+		{
+			Login(client, pCommand);
+		}
+		else if(client.name.empty())
+		{
+			Deny(client, command.c_str(), "Not logged in");
+		}
+		else if(command == "create-game")
+		{
+			CreateGame(client);
+		}
+		else if(command == "join-game")
+		{
+			JoinGame(client, pCommand);
+		}
+		else if(command == "game-start")
+		{
+			StartGame(client);
+		}
+		else if(command == "game-move")
+		{
+			MovePiece(client, pCommand);
+		}
+		else if(command == "end-turn")
+		{
+			EndTurn(client);
+		}
+		else if(command == "game-status")
+		{
+			SendStatus(client);
+		}
+		else if(command == "request-log")
+		{
+			SendLog(client, pCommand);
+		}
+		else
+		{
+			Deny(client, command.c_str(), "Unknown command");
+		}
+	}
+
+	if(pBase != nullptr)
+	{
+		destroy_sexp(pBase);
+	}
+}
+
+void Server::Login(Client& client, const Sexp* pCommand)
+{
+	// Any password is accepted
+	const char* pName = GetArgument(pCommand, 0);
+	if((pName == nullptr) || (*pName == '\0'))
+	{
+		SendMessage(client.socket, "(login-denied \"Missing user name\")");
+		return;
+	}
+
+	client.name = pName;
+	SendMessage(client.socket, "(login-accepted)");
+}
+
+void Server::CreateGame(Client& client)
+{
+	if(client.gameNumber != 0)
+	{
+		Deny(client, "create-game", "Already in a game");
+		return;
+	}
+
+	while(m_games.count(m_nextGameNumber) > 0)
+	{
+		++m_nextGameNumber;
+	}
+
+	std::unique_ptr<Game> pGame(new Game());
+	pGame->number = m_nextGameNumber++;
+	pGame->sockets[0] = client.socket;
+	pGame->names[0] = client.name;
+
+	client.gameNumber = pGame->number;
+	client.playerID = 0;
+
+	std::ostringstream reply;
+	reply << "(game-created " << pGame->number << ")";
+	SendMessage(client.socket, reply.str());
+
+	m_games[pGame->number] = std::move(pGame);
+}
+
+void Server::JoinGame(Client& client, const Sexp* pCommand)
+{
+	int gameNumber = 0;
+	const char* pType = GetArgument(pCommand, 1);
+	if(!GetIntArgument(pCommand, 0, gameNumber) || (gameNumber <= 0))
+	{
+		SendMessage(client.socket, "(join-denied \"Invalid game number\")");
+		return;
+	}
+
+	if(client.gameNumber != 0)
+	{
+		SendMessage(client.socket, "(join-denied \"Already in a game\")");
+		return;
+	}
+
+	if((pType != nullptr) && (std::string(pType) != "player"))
+	{
+		SendMessage(client.socket, "(join-denied \"Only players can join a game\")");
+		return;
+	}
+
+	auto iter = m_games.find(gameNumber);
+	if(iter == m_games.end())
+	{
+		// Joining a game that does not exist creates it, the client becomes its first player
+		std::unique_ptr<Game> pGame(new Game());
+		pGame->number = gameNumber;
+		pGame->sockets[0] = client.socket;
+		pGame->names[0] = client.name;
+
+		client.gameNumber = gameNumber;
+		client.playerID = 0;
+
+		SendMessage(client.socket, "(create-game)");
+		m_games[gameNumber] = std::move(pGame);
+		return;
+	}
+
+	Game& game = *iter->second;
+	if(game.bStarted || game.bOver || (game.sockets[0] == -1) || (game.sockets[1] != -1))
+	{
+		SendMessage(client.socket, "(join-denied \"Game is full\")");
+		return;
+	}
+
+	game.sockets[1] = client.socket;
+	game.names[1] = client.name;
+
+	client.gameNumber = gameNumber;
+	client.playerID = 1;
+
+	SendMessage(client.socket, "(join-accepted)");
+}
+
+void Server::StartGame(Client& client)
+{
+	auto iter = m_games.find(client.gameNumber);
+	if(iter == m_games.end())
+	{
+		Deny(client, "game-start", "Not in a game");
+		return;
+	}
+
+	Game& game = *iter->second;
+	if(game.bStarted || (game.sockets[0] == -1) || (game.sockets[1] == -1))
+		return;
+
+	game.bStarted = true;
+	game.time[0] = game.time[1] = m_clockTime;
+	game.board.LoadFEN(START_POSITION, game.playerIDToMove);
+
+	game.log << "(game " << game.number << " " << Quote(game.names[0]) << " " << Quote(game.names[1]) << " " << m_clockTime << ")\n";
+
+	std::cout << "Game " << game.number << " started: " << game.names[0] << " vs " << game.names[1] << std::endl;
+
+	StartTurn(game);
+}
+
+void Server::MovePiece(Client& client, const Sexp* pCommand)
+{
+	Game* pGame = GetTurnGame(client, "game-move");
+	if(pGame == nullptr)
+		return;
+
+	int pieceID = 0;
+	int file = 0;
+	int rank = 0;
+	int promotion = 0;
+	if(!GetIntArgument(pCommand, 0, pieceID) || !GetIntArgument(pCommand, 1, file) || !GetIntArgument(pCommand, 2, rank) ||
+	   !GetIntArgument(pCommand, 3, promotion))
+	{
+		Deny(client, "game-move", "Expected a piece, a file, a rank and a promotion type");
+		return;
+	}
+
+	if(pGame->bMoved)
+	{
+		Deny(client, "game-move", "Already moved this turn");
+		return;
+	}
+
+	// Captured pieces are kept by the board, so the piece must also be the one on its tile
+	Board& board = pGame->board;
+	const BoardPiece* pPiece = board.GetPiece(pieceID);
+	if((pPiece == nullptr) || (pPiece->owner != client.playerID) || (board.GetPiece(ivec2{pPiece->file, pPiece->rank}) != pPiece))
+	{
+		Deny(client, "game-move", "Not one of your pieces");
+		return;
+	}
+
+	ivec2 from = {pPiece->file, pPiece->rank};
+	ivec2 to = {file, rank};
+
+	for(const BoardMove& move : board.GetMoves(client.playerID))
+	{
+		if((move.from == from) && (move.to == to) && ((move.specialMove != SpecialMove::Promotion) || (move.promotion == promotion)))
+		{
+			board.MakeMove(move);
+
+			// Positions before the move are positions of the game, which are only a draw when repeated three times
+			board.SetRoot();
+
+			PlayedMove playedMove = {int(pGame->moves.size()) + 1, move};
+			pGame->moves.push_back(playedMove);
+			pGame->bMoved = true;
+			return;
+		}
+	}
+
+	Deny(client, "game-move", "Illegal move");
+}
+
+void Server::EndTurn(Client& client)
+{
+	Game* pGame = GetTurnGame(client, "end-turn");
+	if(pGame == nullptr)
+		return;
+
+	Game& game = *pGame;
+	int playerID = game.playerIDToMove;
+
+	if(!game.bMoved)
+	{
+		EndGame(game, !playerID, "Ended the turn without a valid move");
+		return;
+	}
+
+	float turnTime = GetTurnTime(game);
+	game.time[playerID] -= turnTime;
+
+	const BoardMove& move = game.moves.back().move;
+	const BoardPiece* pPiece = game.board.GetPiece(move.to);
+	game.log << "(move " << game.turnNumber << " " << playerID << " " << pPiece->id << " " << move.from.x << " " << move.from.y << " "
+			 << move.to.x << " " << move.to.y << " " << move.promotion << " " << turnTime << ")\n";
+
+	if(game.time[playerID] <= 0.0f)
+	{
+		EndGame(game, !playerID, "Ran out of time");
+		return;
+	}
+
+	++game.turnNumber;
+	game.playerIDToMove = !playerID;
+
+	if(game.board.IsInCheckmate(game.playerIDToMove))
+	{
+		EndGame(game, playerID, "Checkmate");
+		return;
+	}
+
+	if(game.board.IsInStalemate(game.playerIDToMove))
+	{
+		EndGame(game, DRAW_PLAYER_ID, "Stalemate");
+		return;
+	}
+
+	StartTurn(game);
+}
+
+void Server::SendStatus(Client& client)
+{
+	auto iter = m_games.find(client.gameNumber);
+	if((iter == m_games.end()) || !iter->second->bStarted)
+	{
+		Deny(client, "game-status", "Game has not started");
+		return;
+	}
+
+	SendMessage(client.socket, GetStatus(*iter->second, client.playerID));
+}
+
+void Server::SendLog(Client& client, const Sexp* pCommand)
+{
+	int gameNumber = 0;
+	GetIntArgument(pCommand, 0, gameNumber);
+
+	auto iter = m_games.find(gameNumber);
+	if((iter == m_games.end()) || !iter->second->bOver)
+	{
+		Deny(client, "request-log", "Game has not ended");
+		return;
+	}
+
+	const Game& game = *iter->second;
+
+	std::ostringstream reply;
+	reply << "(log " << game.number << " " << Quote(game.log.str()) << ")";
+	SendMessage(client.socket, reply.str());
+
+	// The client waits for the final status of the game after the log
+	SendMessage(client.socket, GetStatus(game, (game.sockets[1] == client.socket) ? 1 : 0));
+}
+
+void Server::Disconnect(int socket)
+{
+	auto clientIter = m_clients.find(socket);
+	if(clientIter == m_clients.end())
+		return;
+
+	Client client = clientIter->second;
+	m_clients.erase(clientIter);
+	close(socket);
+
+	auto gameIter = m_games.find(client.gameNumber);
+	if(gameIter == m_games.end())
+		return;
+
+	Game& game = *gameIter->second;
+	game.sockets[client.playerID] = -1;
+
+	if(!game.bStarted && !game.bOver)
+	{
+		// Nobody played the game, so it is forgotten
+		if(game.sockets[!client.playerID] == -1)
+		{
+			m_games.erase(gameIter);
+		}
+	}
+	else if(!game.bOver)
+	{
+		EndGame(game, !client.playerID, "Opponent disconnected");
+	}
+}
+
+void Server::StartTurn(Game& game)
+{
+	game.bMoved = false;
+	game.turnStart = std::chrono::steady_clock::now();
+
+	int socket = game.sockets[game.playerIDToMove];
+	if(socket != -1)
+	{
+		SendMessage(socket, GetStatus(game, game.playerIDToMove));
+	}
+}
+
+std::string Server::GetStatus(const Game& game, int playerID) const
+{
+	std::ostringstream status;
+	status << "(status (game " << game.turnNumber << " " << playerID << " " << game.number << " " << game.board.GetTurnsToStalemate() << ")";
+
+	// The last move comes first
+	status << " (Move";
+	for(auto iter = game.moves.rbegin(); iter != game.moves.rend(); ++iter)
+	{
+		const BoardMove& move = iter->move;
+		status << " (" << iter->id << " " << move.from.x << " " << move.from.y << " " << move.to.x << " " << move.to.y << " " << move.promotion << ")";
+	}
+
+	status << ") (Piece";
+	for(const std::vector<int>& file : game.board.GetState())
+	{
+		for(int id : file)
+		{
+			const BoardPiece* pPiece = (id != 0) ? game.board.GetPiece(id) : nullptr;
+			if(pPiece != nullptr)
+			{
+				status << " (" << pPiece->id << " " << pPiece->owner << " " << pPiece->file << " " << pPiece->rank << " "
+					   << pPiece->hasMoved << " " << pPiece->type << ")";
+			}
+		}
+	}
+
+	// The clock of the player to move includes the time used so far in the turn
+	status << ") (Player";
+	for(int i = 0; i < 2; ++i)
+	{
+		float time = game.time[i];
+		if(game.bStarted && !game.bOver && (i == game.playerIDToMove))
+		{
+			time -= GetTurnTime(game);
+		}
+
+		status << " (" << i << " " << Quote(game.names[i]) << " " << std::max(time, 0.0f) << ")";
+	}
+
+	status << "))";
+	return status.str();
+}
+
+void Server::EndGame(Game& game, int winnerID, const std::string& reason)
+{
+	game.bOver = true;
+	++m_completedGames;
+
+	std::string winnerName = (winnerID == DRAW_PLAYER_ID) ? "" : game.names[winnerID];
+
+	std::ostringstream winner;
+	winner << "(game-winner " << game.number << " " << Quote(winnerName) << " " << winnerID << " " << Quote(reason) << ")";
+	game.log << winner.str() << "\n";
+
+	std::ostringstream filename;
+	filename << game.number << ".gamelog";
+	std::ofstream file(filename.str().c_str());
+	if(file.good())
+	{
+		file << game.log.str();
+	}
+	else
+	{
+		std::cerr << "Could not write " << filename.str() << std::endl;
+	}
+
+	for(int socket : game.sockets)
+	{
+		if(socket != -1)
+		{
+			SendMessage(socket, winner.str());
+		}
+	}
+
+	std::cout << "Game " << game.number << " ended after " << game.turnNumber << " turns: "
+			  << ((winnerID == DRAW_PLAYER_ID) ? "draw" : (winnerName + " wins")) << " (" << reason << ")" << std::endl;
+}
+
+int Server::CheckClocks()
+{
+	int timeout = -1;
+
+	for(auto& iter : m_games)
+	{
+		Game& game = *iter.second;
+		if(!game.bStarted || game.bOver)
+			continue;
+
+		float remainingTime = game.time[game.playerIDToMove] - GetTurnTime(game);
+		if(remainingTime <= 0.0f)
+		{
+			game.time[game.playerIDToMove] = 0.0f;
+			EndGame(game, !game.playerIDToMove, "Ran out of time");
+			continue;
+		}
+
+		int milliseconds = int(std::ceil(remainingTime * 1000.0f));
+		timeout = (timeout == -1) ? milliseconds : std::min(timeout, milliseconds);
+	}
+
+	return timeout;
+}
+
+Game* Server::GetTurnGame(Client& client, const char* command)
+{
+	auto iter = m_games.find(client.gameNumber);
+	if((iter == m_games.end()) || !iter->second->bStarted || iter->second->bOver)
+	{
+		Deny(client, command, "Game is not running");
+		return nullptr;
+	}
+
+	if(iter->second->playerIDToMove != client.playerID)
+	{
+		Deny(client, command, "Not your turn");
+		return nullptr;
+	}
+
+	return iter->second.get();
+}
+
+void Server::Deny(const Client& client, const char* command, const std::string& reason)
+{
+	SendMessage(client.socket, std::string("(") + command + "-denied " + Quote(reason) + ")");
+}
+
+float Server::GetTurnTime(const Game& game)
+{
+	return std::chrono::duration_cast<std::chrono::duration<float>>(std::chrono::steady_clock::now() - game.turnStart).count();
+}
+
+// server [port] [seconds] [games] plays games between clients on the loopback interface with the rules and clocks of the game server.
+// The log of each game is written to <game number>.gamelog, the server exits after the number of games if it is not 0
+int main(int argc, char** argv)
+{
+	const char* port = (argc > 1) ? argv[1] : DEFAULT_PORT;
+	float clockTime = (argc > 2) ? float(std::atof(argv[2])) : DEFAULT_CLOCK_TIME;
+	unsigned int maxGames = (argc > 3) ? std::atoi(argv[3]) : 0;
+
+	if(clockTime <= 0.0f)
+	{
+		std::cerr << "usage: server [port] [seconds] [games]" << std::endl;
+		return 1;
+	}
+
+	Server server(clockTime, maxGames);
+	if(!server.Listen(port))
+	{
+		std::cerr << "Unable to listen on port " << port << std::endl;
+		return 1;
+	}
+
+	server.Run();
+
+	return 0;
+}